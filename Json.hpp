@@ -1,3 +1,4 @@
+#pragma once
 #include <iostream>
 #include <variant>
 #include <vector>
@@ -6,6 +7,13 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+#include <array>
+#include <chrono>
+#include <memory>
 
 namespace json
 {
@@ -19,34 +27,179 @@ namespace json
     using Int = int64_t;
     using Float = double;
     using String = std::string;
+
+    // 全局 key 驻留表：每个不同的 key 只保存一份，线程安全，条目永不释放。
+    // 适合 key 种类有限（几百个）但重复出现几百万次的文档。
+    class KeyTable
+    {
+    public:
+        struct Entry
+        {
+            const std::string *str;
+            uint32_t id; // 按第一次驻留的顺序分配
+        };
+        static auto intern(std::string_view key) -> Entry;
+        static auto find(std::string_view key) -> std::optional<Entry>; // 只查找不插入，没驻留过返回空
+        static auto size() -> size_t;
+
+    private:
+        struct Storage
+        {
+            std::shared_mutex mutex;
+            std::deque<std::string> strings; // deque 扩容时不会移动已有元素，指针一直有效
+            std::unordered_map<std::string_view, uint32_t> ids;
+        };
+        // 第一次用到时才构造，其它文件的静态对象初始化时（例如用 parser() 解析内嵌的默认配置）也能安全驻留
+        static auto storage() -> Storage &;
+    };
+
+    // 驻留后的 key，只有 16 字节，比较时只比较整数 id，不再逐字符比较字符串
+    class InternedKey
+    {
+    public:
+        InternedKey(std::string_view key) : entry(KeyTable::intern(key)) {}
+        InternedKey(const std::string &key) : InternedKey(std::string_view{key}) {}
+        InternedKey(const char *key) : InternedKey(std::string_view{key}) {}
+        explicit InternedKey(KeyTable::Entry entry) : entry(entry) {}
+
+        auto id() const -> uint32_t { return entry.id; }
+        auto str() const -> const std::string & { return *entry.str; }
+        operator const std::string &() const { return *entry.str; }
+
+        bool operator==(const InternedKey &rhs) const { return entry.str == rhs.entry.str; }
+        bool operator<(const InternedKey &rhs) const { return entry.id < rhs.entry.id; }
+        // 查找用：没驻留过的 key 一定不在任何 Object 里，直接返回空，不会让驻留表增长
+        static auto lookup(std::string_view key) -> std::optional<InternedKey>
+        {
+            auto entry = KeyTable::find(key);
+            return entry ? std::optional<InternedKey>{InternedKey{*entry}} : std::nullopt;
+        }
+
+    private:
+        KeyTable::Entry entry;
+    };
+
+    // 定义 JSON_INTERN_KEYS 后 Object 的 key 换成 InternedKey（整个程序要统一定义）。
+    // 此时 std::map 内部按 id 排序，遍历顺序取决于进程里 key 第一次驻留的先后；
+    // JsonGenerator 输出时会按字符串重新排序，所以生成的文本与不驻留时完全一样。
+#ifdef JSON_INTERN_KEYS
+    using Key = InternedKey;
+#else
+    using Key = std::string;
+#endif
     using Array = std::vector<Node>;
-    using Object = std::map<std::string, Node>;
+    using Object = std::map<Key, Node>;
     using Value = std::variant<Null, Bool, Int, Float, String, Array, Object>;
 
+    // 只查找不插入的 key 查找。不直接用 object.find(key) 是因为驻留模式下把 std::string 转成 Key 会驻留它，
+    // 来自外部的查找（例如网络传来的 patch 路径）会让全局驻留表无限增长。
+    template <class ObjectType>
+    auto find_key(ObjectType &object, std::string_view key) -> decltype(object.begin())
+    {
+#ifdef JSON_INTERN_KEYS
+        auto interned = InternedKey::lookup(key);
+        return interned ? object.find(*interned) : object.end();
+#else
+        return object.find(std::string{key});
+#endif
+    }
+
     // 这种设计允许 Node 对象的 value 成员根据需要存储不同类型的数据，可以是基本数据类型（Bool、Int、Float、String）或复杂数据类型（Array、Object），并提供一种统一的访问方式，即使用 operator[] 进行属性或成员的访问。
     struct Node
     {
         Value value;
+        // JsonGenerator::generate_cached 的增量状态。容器在第一次 generate_cached 时分配，标量只有通过 operator[] 拿到过
+        // 可修改的引用才分配。Link 放在堆上，节点被移动（例如 vector 扩容）时它不动，子节点里指向它的 parent 不用更新。
+        struct Link
+        {
+            std::shared_ptr<Link> parent; // 所在容器的 Link，修改时沿着它向上标记
+            bool dirty = true;            // 上次生成之后修改过。dirty 节点的祖先一定也是 dirty
+            bool cached = false;
+            // 缓存的文本：buffer 不为空时是 buffer 里从 offset 开始的 length 字节（只有生成的根节点这样保存），
+            // 否则是 parent 文本里从 offset 开始的一段，只在 parent 的 version 还等于 parent_version 时有效。
+            // 整棵树的文本只在根节点保存一份，子树的缓存都只是位置
+            std::shared_ptr<const std::string> buffer;
+            size_t offset = 0;
+            size_t length = 0;
+            uint64_t version = 0; // 自己的文本每重新生成一次加一
+            uint64_t parent_version = 0;
+        };
+        std::shared_ptr<Link> link;
         // 构造函数
         Node() : value(Null{}) {}
-        Node(Value _value) : value(_value) {}
+        Node(Value _value) : value(std::move(_value)) {}
+        // 拷贝出来的是新节点，不带 link；移动（例如 vector 扩容）时 link 跟着值走
+        Node(const Node &other) : value(other.value) {}
+        Node(Node &&other) noexcept : value(std::move(other.value)), link(std::move(other.link)) {}
+        // 赋值整体换掉内容，算一次修改
+        Node &operator=(const Node &other)
+        {
+            value = other.value;
+            touch();
+            return *this;
+        }
+        // 移动赋值时 link 也跟着值走，数组删除/插入元素时挪动的元素保留缓存，只有所在的容器算修改
+        Node &operator=(Node &&other);
+
+        // 标记这个节点已修改，并沿着 parent 向上标记到根。修改在发生时就传播，generate_cached 不用遍历整棵树。
+        // 绕过 Node 的接口直接改 value 时（例如 std::get<Array>(node.value).pop_back()），需要对被改的容器调用
+        void touch()
+        {
+            for (auto *l = link.get(); l && !l->dirty; l = l->parent.get())
+            {
+                l->dirty = true;
+            }
+        }
 
-        auto& operator[](const std::string &key)
+        // 绕过 Node 的接口把 child 放进这个节点的 value 后调用（operator[] 和 push 会自动调用），
+        // 把 child 接到这个节点上，以后通过 child 的引用做的修改才能传播上来；这个节点本身算修改
+        void adopt(Node &child);
+
+        // 可修改的查找：key 不存在时插入 null。返回的节点接在这个节点上，以后通过它做的修改会传播到这里
+        auto& operator[](const Key &key)
         {
             // 重载了 operator[] 的成员函数，用于从一个类（或结构体）中获取键为 std::string 类型的成员（或属性）。该代码的实现假设 value 是一个 std::variant，可以包含不同类型的值，其中之一是 Object 类型Object=std::map<std::string,Node>;。
             // std::get_if 函数的作用是检查 value 是否包含 Object 类型的值，并且返回一个指向该值的指针（如果包含），或者返回 nullptr（如果不包含或者 value 当前存储的不是 Object 类型的值）。
             if (auto object = std::get_if<Object>(&value))
             {
-                return (*object)[key];
+                auto [it, inserted] = object->try_emplace(key);
+                inserted ? adopt(it->second) : attach(it->second);
+                return it->second;
+            }
+            throw std::runtime_error("not an object");
+        }
+
+        auto &operator[](size_t index)
+        {
+            if (auto array = std::get_if<Array>(&value))
+            {
+                auto &child = array->at(index); // vector类型
+                attach(child);
+                return child;
+            }
+            throw std::runtime_error("not an array");
+        }
+
+        // 只读查找：不插入、不驻留 key，也不分配 link。key 不存在时抛出 std::out_of_range
+        auto operator[](std::string_view key) const -> const Node &
+        {
+            if (auto object = std::get_if<Object>(&value))
+            {
+                auto it = find_key(*object, key);
+                if (it == object->end())
+                {
+                    throw std::out_of_range("json key not found");
+                }
+                return it->second;
             }
             throw std::runtime_error("not an object");
         }
 
-        auto operator[](size_t index)
+        auto operator[](size_t index) const -> const Node &
         {
             if (auto array = std::get_if<Array>(&value))
             {
-                return array->at(index); // vector类型
+                return array->at(index);
             }
             throw std::runtime_error("not an array");
         }
@@ -56,15 +209,127 @@ namespace json
             if (auto array = std::get_if<Array>(&value))
             {
                 array->push_back(rhs);
+                adopt(array->back());
             }
         }
+
+        // 深度比较两个节点，类型也必须相同（1 和 1.0 不相等），JsonPatch::diff 依赖它
+        bool operator==(const Node &rhs) const
+        {
+            return value == rhs.value;
+        }
+
+    private:
+        // 把已经在 value 里、内容没变的 child 接到这个节点上，不算修改
+        void attach(Node &child);
+    };
+
+    // 按 JSON 的语义比较：数字按数值比较，1 和 1.0 相等（RFC 6902 的 test 操作这样要求），其它类型逐层比较。
+    // JsonPatch 的 test 和 schema 的 enum 都用它；Node::operator== 还要求类型相同。
+    auto json_equal(const Value &lhs, const Value &rhs) -> bool;
+
+    // 解析/生成的统计信息。只有定义了 JSON_ENABLE_STATS 才会计数，
+    // 否则下面的 JSON_STAT / JSON_PHASE / JSON_PROBE 埋点全部展开为空，没有任何开销。
+    // 统计按线程保存，通过 json::stats() 读取。
+    struct Stats
+    {
+        enum Phase
+        {
+            Scan,      // 扫描字符串、数字等叶子 token
+            Parse,     // JsonParser::parse 总耗时（包含 Scan 和 Build）
+            Build,     // 把子节点插入 Array / Object
+            Serialize, // JsonGenerator::generate
+            PhaseCount
+        };
+
+        uint64_t bytes_scanned = 0;
+        std::array<uint64_t, std::variant_size_v<Value>> nodes{}; // 下标与 Value 的 index() 一致
+        uint64_t max_depth = 0;
+        uint64_t strings = 0;
+        uint64_t escapes = 0;
+        uint64_t number_fast_path = 0; // 不超过 18 位的整数，直接逐位累加
+        uint64_t number_fallback = 0;  // 其余数字走 std::stod / std::stoll
+        uint64_t allocations = 0;      // 按容器和字符串的增长估算，不是真正 hook operator new
+        uint64_t bytes_allocated = 0;
+        std::array<uint64_t, PhaseCount> phase_ns{};
+
+        auto to_node() const -> Node; // 导出成 JSON，方便和请求日志一起上报
     };
 
+    auto stats() -> Stats &;
+    auto reset_stats() -> void;
+
+    // 统计一个阶段的耗时；同一阶段递归嵌套时只计最外层
+    class PhaseTimer
+    {
+    public:
+        explicit PhaseTimer(Stats::Phase phase);
+        ~PhaseTimer();
+
+    private:
+        Stats::Phase phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
+#ifdef JSON_ENABLE_STATS
+#define JSON_STAT(expr) ((void)(::json::stats().expr))
+#define JSON_STATS_ONLY(...) __VA_ARGS__
+#define JSON_PHASE_CONCAT(a, b) a##b
+#define JSON_PHASE_NAME(line) JSON_PHASE_CONCAT(json_phase_timer_, line)
+#define JSON_PHASE(phase) ::json::PhaseTimer JSON_PHASE_NAME(__LINE__){::json::Stats::phase}
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+// USDT 探针，可以用 perf / bpftrace 挂上去：perf probe sdt_zyl_json:parse_done
+#define JSON_PROBE(name, arg) DTRACE_PROBE1(zyl_json, name, arg)
+#else
+#define JSON_PROBE(name, arg) ((void)(arg))
+#endif
+#else
+#define JSON_STAT(expr) ((void)0)
+#define JSON_STATS_ONLY(...)
+#define JSON_PHASE(phase) ((void)0)
+#define JSON_PROBE(name, arg) ((void)0)
+#endif
+
+    // 编译后的 JSON Schema，支持的子集：type、required、properties、enum、minimum、maximum、maxLength、items，
+    // 布尔 schema true / false，以及扩展关键字 "x-ignore": true（只能用在 properties 下的字段上，
+    // 校验时跳过该字段，也不为它构造 Node）。
+    // 每个子 schema 编译成一个状态，JsonParser 在递归下降时跟着状态走，解析的同时完成校验。
+    struct Schema
+    {
+        static constexpr size_t any = static_cast<size_t>(-1); // 没有任何约束的状态
+
+        struct State
+        {
+            uint8_t types = 0x7f; // 允许的类型，第 i 位对应 Value 的 index() == i；为 0 时拒绝一切（schema 为 false）
+            bool integral = false; // "type": "integer"：Float 只接受没有小数部分的值，例如 1.0
+            std::vector<std::string> required;
+            std::map<std::string, size_t> properties; // key -> 子状态
+            std::vector<Node> enumeration;             // 为空表示不限制
+            std::optional<Float> minimum;
+            std::optional<Float> maximum;
+            std::optional<size_t> max_length;
+            size_t items = any;
+            bool ignored = false;
+        };
+        std::vector<State> states; // states[0] 是根
+    };
+
+    // schema 本身不合法或者用到了不支持的关键字时抛出 std::runtime_error
+    auto compile_schema(const Node &schema) -> Schema;
+
     struct JsonParser
     {
         std::string_view json_str;
         size_t pos = 0;
+        size_t depth = 0; // 当前嵌套深度，只在开启统计时维护
+        const Schema *schema = nullptr; // 设置后边解析边校验，不通过时 parse() 返回空
+        size_t state = Schema::any;     // 当前值对应的 schema 状态
+        std::string error{};            // 校验失败的原因
         void parse_whitespace();
+        void skip_value();
+        bool check_type();
+        bool check_value(const Value &value);
 
         // std::optional<Value>，表示可能返回一个 Value 类型的值，也可能不返回任何值（即空值）。
         auto parse_null() -> std::optional<Value>;
@@ -78,16 +343,28 @@ namespace json
         auto parse() -> std::optional<Node>;
     };
 
-    auto parser(std::string_view json_str) -> std::optional<Node>
+    inline auto parser(std::string_view json_str) -> std::optional<Node>
+    {
+        JsonParser p{json_str};
+        return p.parse();
+    }
+
+    inline auto parser(std::string_view json_str, const Schema &schema) -> std::optional<Node>
     {
         JsonParser p{json_str};
+        p.schema = &schema;
         return p.parse();
     }
 
     class JsonGenerator
     {
     public:
-        static auto generate(const Node &node) -> std::string;
+        static constexpr size_t cache_threshold = 64; // 文本不短于这个长度的 Array / Object 才缓存
+
+        static auto generate(const Node &node) -> std::string; // 不读也不写缓存，可以在多个线程里同时生成同一棵树
+        // 增量生成：没有修改过的子树直接拼接缓存的文本，不再往下走，只重新序列化修改路径上的容器，耗时取决于修改了多少。
+        // 会写 node 里的 link，所以和修改一样，不能与其它线程同时访问这棵树。
+        static auto generate_cached(Node &node) -> std::string;
         static auto generate_string(const String &str) -> std::string;
         static auto generate_array(const Array &array) -> std::string;
         static auto generate_object(const Object &object) -> std::string;
@@ -98,7 +375,126 @@ namespace json
         return JsonGenerator::generate(node);
     }
 
-    auto operator<<(std::ostream &out, const Node &t) -> std::ostream &
+    inline auto generate_cached(Node &node) -> std::string
+    {
+        return JsonGenerator::generate_cached(node);
+    }
+
+    // JSON Patch (RFC 6902) 与 Merge Patch (RFC 7386)，直接在原来的 Node 树上修改，不重建整棵树。
+    // 路径使用 JSON Pointer (RFC 6901)，例如 "/configurations/0"；操作失败时抛出 std::runtime_error。
+    // apply 是原子的：任何一个操作失败时，前面已经执行的操作都会被撤销，doc 保持调用前的内容。
+    class JsonPatch
+    {
+    public:
+        static auto apply(Node &doc, const Node &patch) -> void;       // patch 是由 op 对象组成的 Array
+        static auto merge(Node &doc, const Node &merge_patch) -> void; // RFC 7386，null 表示删除
+        static auto diff(const Node &from, const Node &to) -> Node;    // 生成把 from 变成 to 的 patch
+    };
+
+    // 列式（struct-of-arrays）数据：一个字段一列，数值放在连续的 vector 里，方便下游直接做向量化聚合。
+    struct Column
+    {
+        std::string name;
+        size_t type = 0;                // 与 Value 的 index() 一致：1 bool, 2 int, 3 float, 4 string
+        std::vector<Int> ints;          // bool 列（存 0/1）和 int 列
+        std::vector<Float> floats;      // float 列，int 值会被转换成 double
+        std::vector<size_t> offsets{0}; // string 列：第 i 行是 bytes[offsets[i], offsets[i + 1])
+        std::string bytes;
+        std::vector<uint64_t> validity; // 位图，第 i 位为 1 表示第 i 行有值；缺失、null 或类型不符时为 0
+
+        auto size() const -> size_t;
+        auto is_valid(size_t row) const -> bool { return validity[row / 64] >> (row % 64) & 1; }
+        auto string_at(size_t row) const -> std::string_view { return std::string_view{bytes}.substr(offsets[row], offsets[row + 1] - offsets[row]); }
+    };
+
+    struct ColumnTable
+    {
+        size_t rows = 0;
+        std::vector<Column> columns;
+
+        auto column(std::string_view name) const -> const Column *; // 找不到返回 nullptr
+    };
+
+    // 把由对象组成的数组抽取成列。列的集合和类型由前 infer_rows 条记录推断：
+    // 只保留类型一致的标量字段（int 和 float 混合时按 float），数组、对象以及类型冲突的字段会被丢弃。
+    // 元素不是对象时抛出 std::runtime_error。
+    auto extract_columns(const Node &array, size_t infer_rows = 64) -> ColumnTable;
+    // 直接从文本抽取：推断完成后不再为每条记录构造 Object，不需要的字段只扫描跳过
+    auto extract_columns(std::string_view json_str, size_t infer_rows = 64) -> ColumnTable;
+
+    // 把 JSON Pointer（例如 "/a/0/b~1c"）拆成还原过转义的 token，"" 表示整个文档
+    auto split_pointer(const std::string &path) -> std::vector<std::string>;
+
+    // 拉取式地逐个读取巨大的顶层数组（或 path 指向的数组）里的元素。
+    // 只保留一个固定大小的读缓冲和当前元素，内存占用与数组总长度无关：
+    //     std::ifstream fin("huge.json");
+    //     for (auto &node : ArrayReader{fin, "/records"}) { ... }
+    // 输入格式错误或 path 不存在时抛出 std::runtime_error。
+    class ArrayReader
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Node;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Node *;
+            using reference = Node &;
+
+            iterator() = default;
+            explicit iterator(ArrayReader *reader) : reader(reader) { ++*this; }
+
+            auto operator*() const -> Node & { return *current; }
+            auto operator->() const -> Node * { return &*current; }
+            auto operator++() -> iterator &;
+            void operator++(int) { ++*this; }
+            bool operator==(const iterator &rhs) const { return reader == rhs.reader; }
+
+        private:
+            ArrayReader *reader = nullptr; // nullptr 表示 end()
+            mutable std::optional<Node> current; // 解引用得到的元素可以被调用方 move 走
+        };
+
+        explicit ArrayReader(std::istream &in, const std::string &path = "", size_t buffer_size = 64 * 1024);
+
+        auto next() -> std::optional<Node>; // 读出下一个元素，数组结束时返回空
+        auto begin() -> iterator { return iterator{this}; }
+        auto end() -> iterator { return iterator{}; }
+
+    private:
+        auto peek() -> int;
+        auto get() -> int;
+        void expect(char c);
+        void skip_whitespace();
+        void read_value(std::string *out); // out 为 nullptr 时只跳过不保存
+        void seek(const std::vector<std::string> &tokens);
+
+        std::istream &in;
+        std::vector<char> buffer;
+        size_t head = 0, tail = 0;
+        bool started = false;
+        bool finished = false;
+        std::vector<std::string> tokens;
+        std::string element; // 当前元素的原始文本，容量会被复用
+    };
+
+    inline auto apply_patch(Node &doc, const Node &patch) -> void
+    {
+        JsonPatch::apply(doc, patch);
+    }
+
+    inline auto apply_merge_patch(Node &doc, const Node &merge_patch) -> void
+    {
+        JsonPatch::merge(doc, merge_patch);
+    }
+
+    inline auto diff(const Node &from, const Node &to) -> Node
+    {
+        return JsonPatch::diff(from, to);
+    }
+
+    inline auto operator<<(std::ostream &out, const Node &t) -> std::ostream &
     {
         out << JsonGenerator::generate(t);
         return out;
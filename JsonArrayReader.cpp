@@ -0,0 +1,232 @@
+#include "Json.hpp"
+#include <stdexcept>
+
+namespace json
+{
+    ArrayReader::iterator &ArrayReader::iterator::operator++()
+    {
+        current = reader->next();
+        if (!current)
+        {
+            reader = nullptr; // 读完了，变成 end()
+        }
+        return *this;
+    }
+
+    ArrayReader::ArrayReader(std::istream &in, const std::string &path, size_t buffer_size)
+        : in(in), buffer(buffer_size), tokens(split_pointer(path))
+    {
+    }
+
+    int ArrayReader::peek()
+    {
+        if (head == tail)
+        {
+            // 缓冲区读空了再从流里补一块，始终只占用 buffer.size() 字节
+            in.read(buffer.data(), buffer.size());
+            head = 0;
+            tail = static_cast<size_t>(in.gcount());
+            if (tail == 0)
+            {
+                return EOF;
+            }
+        }
+        return static_cast<unsigned char>(buffer[head]);
+    }
+
+    int ArrayReader::get()
+    {
+        int c = peek();
+        if (c != EOF)
+        {
+            head++;
+        }
+        return c;
+    }
+
+    void ArrayReader::expect(char c)
+    {
+        if (get() != c)
+        {
+            throw std::runtime_error(std::string{"array reader: expected '"} + c + "'");
+        }
+    }
+
+    void ArrayReader::skip_whitespace()
+    {
+        while (peek() != EOF && std::isspace(peek()))
+        {
+            head++;
+        }
+    }
+
+    void ArrayReader::read_value(std::string *out)
+    {
+        // 只做词法层面的切分：记录括号深度、识别字符串（包括里面的转义），
+        // 具体的语法交给 JsonParser 去解析切出来的这一段。
+        skip_whitespace();
+        size_t depth = 0;
+        bool in_string = false;
+        while (true)
+        {
+            int c = peek();
+            if (c == EOF)
+            {
+                throw std::runtime_error("array reader: unexpected end of input");
+            }
+            if (!in_string && depth == 0 && (c == ',' || c == ']' || c == '}' || std::isspace(c)))
+            {
+                return; // 标量结束
+            }
+            head++;
+            if (out)
+            {
+                *out += static_cast<char>(c);
+            }
+            if (in_string)
+            {
+                if (c == '\\')
+                {
+                    int escaped = get();
+                    if (escaped == EOF)
+                    {
+                        throw std::runtime_error("array reader: unexpected end of input");
+                    }
+                    if (out)
+                    {
+                        *out += static_cast<char>(escaped);
+                    }
+                }
+                else if (c == '"')
+                {
+                    in_string = false;
+                    if (depth == 0)
+                    {
+                        return;
+                    }
+                }
+            }
+            else if (c == '"')
+            {
+                in_string = true;
+            }
+            else if (c == '[' || c == '{')
+            {
+                depth++;
+            }
+            else if (c == ']' || c == '}')
+            {
+                if (--depth == 0)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    void ArrayReader::seek(const std::vector<std::string> &tokens)
+    {
+        // 按 JSON Pointer 一层层往下走，路径之外的值只跳过不保存
+        for (const auto &token : tokens)
+        {
+            skip_whitespace();
+            int c = get();
+            if (c == '{')
+            {
+                std::string key;
+                while (true)
+                {
+                    skip_whitespace();
+                    if (peek() != '"')
+                    {
+                        throw std::runtime_error("array reader: path not found: " + token);
+                    }
+                    key.clear();
+                    read_value(&key);
+                    skip_whitespace();
+                    expect(':');
+                    if (key.substr(1, key.size() - 2) == token)
+                    {
+                        break;
+                    }
+                    read_value(nullptr);
+                    skip_whitespace();
+                    if (peek() == ',')
+                    {
+                        head++;
+                    }
+                }
+            }
+            else if (c == '[')
+            {
+                size_t index = 0;
+                for (char ch : token)
+                {
+                    if (!std::isdigit(static_cast<unsigned char>(ch)))
+                    {
+                        throw std::runtime_error("array reader: invalid array index: " + token);
+                    }
+                    index = index * 10 + (ch - '0');
+                }
+                for (size_t i = 0; i < index; i++)
+                {
+                    skip_whitespace();
+                    if (peek() == ']')
+                    {
+                        throw std::runtime_error("array reader: path not found: " + token);
+                    }
+                    read_value(nullptr);
+                    skip_whitespace();
+                    if (peek() == ',')
+                    {
+                        head++;
+                    }
+                }
+            }
+            else
+            {
+                throw std::runtime_error("array reader: path not found: " + token);
+            }
+        }
+        skip_whitespace();
+        expect('[');
+    }
+
+    std::optional<Node> ArrayReader::next()
+    {
+        if (finished)
+        {
+            return {};
+        }
+        if (!started)
+        {
+            started = true;
+            seek(tokens);
+        }
+        skip_whitespace();
+        if (peek() == ']')
+        {
+            head++;
+            finished = true;
+            return {};
+        }
+        element.clear();
+        read_value(&element);
+        skip_whitespace();
+        if (peek() == ',')
+        {
+            head++;
+        }
+        else if (peek() != ']')
+        {
+            throw std::runtime_error("array reader: expected ',' or ']'");
+        }
+        JsonParser p{element};
+        auto node = p.parse();
+        if (!node)
+        {
+            throw std::runtime_error("array reader: invalid element: " + element);
+        }
+        return node;
+    }
+}
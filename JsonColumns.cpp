@@ -0,0 +1,338 @@
+#include "Json.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace json
+{
+    namespace
+    {
+        constexpr size_t conflict = static_cast<size_t>(-1);
+
+        // 合并两次观察到的类型，0 表示只见过 null
+        size_t merge_type(size_t lhs, size_t rhs)
+        {
+            if (lhs == 0 || lhs == rhs)
+            {
+                return rhs;
+            }
+            if (rhs == 0)
+            {
+                return lhs;
+            }
+            if ((lhs == 2 && rhs == 3) || (lhs == 3 && rhs == 2))
+            {
+                return 3;
+            }
+            return conflict;
+        }
+
+        // 直接在原数组的 [first, last) 上推断，不复制样本
+        ColumnTable infer(Array::const_iterator first, Array::const_iterator last)
+        {
+            std::vector<std::string> names; // 按第一次出现的顺序
+            std::map<std::string, size_t> types;
+            for (; first != last; ++first)
+            {
+                const Node &record = *first;
+                auto object = std::get_if<Object>(&record.value);
+                if (!object)
+                {
+                    throw std::runtime_error("columns: records must be objects");
+                }
+                for (const auto &[key, node] : *object)
+                {
+                    size_t type = node.value.index();
+                    if (type > 4)
+                    {
+                        type = conflict; // 数组和对象不能放进列里
+                    }
+                    auto [it, inserted] = types.emplace(key, type);
+                    if (inserted)
+                    {
+                        names.push_back(key);
+                    }
+                    else if (it->second != conflict)
+                    {
+                        it->second = type == conflict ? conflict : merge_type(it->second, type);
+                    }
+                }
+            }
+            ColumnTable table;
+            for (const auto &name : names)
+            {
+                size_t type = types[name];
+                if (type != 0 && type != conflict)
+                {
+                    Column column;
+                    column.name = name;
+                    column.type = type;
+                    table.columns.push_back(std::move(column));
+                }
+            }
+            return table;
+        }
+
+        void set_valid(Column &column, size_t row)
+        {
+            column.validity[row / 64] |= uint64_t{1} << (row % 64);
+        }
+
+        // 往列尾追加一行，值不能放进这一列时追加一个无效的占位值，保证各列长度一致
+        void append(Column &column, const Value *value)
+        {
+            size_t row = column.size();
+            if (column.validity.size() * 64 <= row)
+            {
+                column.validity.push_back(0);
+            }
+            switch (column.type)
+            {
+            case 1:
+            case 2:
+            {
+                auto b = value ? std::get_if<Bool>(value) : nullptr;
+                auto i = value ? std::get_if<Int>(value) : nullptr;
+                if (column.type == 1 ? b != nullptr : i != nullptr)
+                {
+                    column.ints.push_back(b ? Int{*b} : *i);
+                    set_valid(column, row);
+                }
+                else
+                {
+                    column.ints.push_back(0);
+                }
+                break;
+            }
+            case 3:
+            {
+                auto i = value ? std::get_if<Int>(value) : nullptr;
+                auto f = value ? std::get_if<Float>(value) : nullptr;
+                if (i || f)
+                {
+                    column.floats.push_back(i ? static_cast<Float>(*i) : *f);
+                    set_valid(column, row);
+                }
+                else
+                {
+                    column.floats.push_back(0);
+                }
+                break;
+            }
+            default:
+            {
+                if (auto str = value ? std::get_if<String>(value) : nullptr)
+                {
+                    column.bytes += *str;
+                    set_valid(column, row);
+                }
+                column.offsets.push_back(column.bytes.size());
+                break;
+            }
+            }
+        }
+
+        void pop(Column &column)
+        {
+            size_t row = column.size() - 1;
+            column.validity[row / 64] &= ~(uint64_t{1} << (row % 64));
+            switch (column.type)
+            {
+            case 1:
+            case 2:
+                column.ints.pop_back();
+                break;
+            case 3:
+                column.floats.pop_back();
+                break;
+            default:
+                column.offsets.pop_back();
+                column.bytes.resize(column.offsets.back());
+                break;
+            }
+        }
+
+        void append_record(ColumnTable &table, const Node &record)
+        {
+            auto object = std::get_if<Object>(&record.value);
+            if (!object)
+            {
+                throw std::runtime_error("columns: records must be objects");
+            }
+            for (auto &column : table.columns)
+            {
+                auto it = find_key(*object, column.name);
+                append(column, it == object->end() ? nullptr : &it->second.value);
+            }
+            table.rows++;
+        }
+
+        // 文本路径：逐个 key 查列下标，直接把值写进列，不构造 Object
+        void append_record(ColumnTable &table, JsonParser &p, const std::unordered_map<std::string, size_t> &index)
+        {
+            if (p.pos >= p.json_str.size() || p.json_str[p.pos] != '{')
+            {
+                throw std::runtime_error("columns: records must be objects");
+            }
+            p.pos++; //{
+            while (true)
+            {
+                p.parse_whitespace();
+                if (p.pos >= p.json_str.size() || p.json_str[p.pos] != '"')
+                {
+                    break;
+                }
+                auto key = p.parse_string();
+                p.parse_whitespace();
+                if (p.pos >= p.json_str.size() || p.json_str[p.pos] != ':')
+                {
+                    throw std::runtime_error("columns: expected ':'");
+                }
+                p.pos++;
+                auto it = index.find(std::get<String>(*key));
+                if (it == index.end())
+                {
+                    p.skip_value(); // 不需要的字段只扫描跳过
+                }
+                else
+                {
+                    p.parse_whitespace();
+                    auto value = p.parse_value();
+                    if (!value)
+                    {
+                        throw std::runtime_error("columns: invalid value at offset " + std::to_string(p.pos));
+                    }
+                    Column &column = table.columns[it->second];
+                    if (column.size() > table.rows)
+                    {
+                        pop(column); // 重复的 key 与 parse_object 一致，以最后一个为准
+                    }
+                    append(column, &*value);
+                }
+                p.parse_whitespace();
+                if (p.pos < p.json_str.size() && p.json_str[p.pos] == ',')
+                {
+                    p.pos++;
+                }
+            }
+            if (p.pos >= p.json_str.size() || p.json_str[p.pos] != '}')
+            {
+                throw std::runtime_error("columns: expected '}'");
+            }
+            p.pos++; //}
+            for (auto &column : table.columns)
+            {
+                if (column.size() == table.rows)
+                {
+                    append(column, nullptr); // 这一行没有这个字段
+                }
+            }
+            table.rows++;
+        }
+    }
+
+    size_t Column::size() const
+    {
+        switch (type)
+        {
+        case 1:
+        case 2:
+            return ints.size();
+        case 3:
+            return floats.size();
+        default:
+            return offsets.size() - 1;
+        }
+    }
+
+    const Column *ColumnTable::column(std::string_view name) const
+    {
+        for (const auto &column : columns)
+        {
+            if (column.name == name)
+            {
+                return &column;
+            }
+        }
+        return nullptr;
+    }
+
+    ColumnTable extract_columns(const Node &array, size_t infer_rows)
+    {
+        auto records = std::get_if<Array>(&array.value);
+        if (!records)
+        {
+            throw std::runtime_error("not an array");
+        }
+        ColumnTable table = infer(records->begin(), records->begin() + std::min(infer_rows, records->size()));
+        for (auto &column : table.columns)
+        {
+            if (column.type == 3)
+            {
+                column.floats.reserve(records->size());
+            }
+            else if (column.type != 4)
+            {
+                column.ints.reserve(records->size());
+            }
+        }
+        for (const auto &record : *records)
+        {
+            append_record(table, record);
+        }
+        return table;
+    }
+
+    ColumnTable extract_columns(std::string_view json_str, size_t infer_rows)
+    {
+        JsonParser p{json_str};
+        p.parse_whitespace();
+        if (p.pos >= json_str.size() || json_str[p.pos] != '[')
+        {
+            throw std::runtime_error("not an array");
+        }
+        p.pos++; //[
+        auto next = [&]() -> bool
+        {
+            // 跳到下一个元素的开头，数组结束时返回 false
+            p.parse_whitespace();
+            if (p.pos < json_str.size() && json_str[p.pos] == ',')
+            {
+                p.pos++;
+                p.parse_whitespace();
+            }
+            if (p.pos >= json_str.size())
+            {
+                throw std::runtime_error("columns: unexpected end of input");
+            }
+            return json_str[p.pos] != ']';
+        };
+
+        // 先完整解析前 infer_rows 条记录用来推断列
+        Array sample;
+        while (sample.size() < infer_rows && next())
+        {
+            auto value = p.parse_value();
+            if (!value)
+            {
+                throw std::runtime_error("columns: invalid record at offset " + std::to_string(p.pos));
+            }
+            sample.push_back(Node{std::move(*value)});
+        }
+        ColumnTable table = infer(sample.begin(), sample.end());
+        for (const auto &record : sample)
+        {
+            append_record(table, record);
+        }
+
+        std::unordered_map<std::string, size_t> index;
+        for (size_t i = 0; i < table.columns.size(); i++)
+        {
+            index.emplace(table.columns[i].name, i);
+        }
+        while (next())
+        {
+            append_record(table, p, index);
+        }
+        return table;
+    }
+}
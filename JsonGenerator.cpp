@@ -1,89 +1,330 @@
 #include "Json.hpp"
+#include <algorithm>
 
 namespace json
 {
-    std::string JsonGenerator::generate(const Node &node)
+    namespace
     {
-        // 用于根据 Node 对象生成对应的 JSON 字符串表示。
+        bool is_container(const Node &node)
+        {
+            return std::holds_alternative<Array>(node.value) || std::holds_alternative<Object>(node.value);
+        }
 
-        // std::visit 是 C++17 引入的 std::variant 的访问器，用于根据 node.value 的类型执行不同的操作。
-        // 它接收一个 lambda 函数和一个 std::variant 类型的值 node.value，根据 node.value 的实际类型执行不同的逻辑。
-        return std::visit(
-            [](auto &&arg) -> std::string //`&&`: 表示引用折叠，根据参数 `arg` 的实际类型来决定是左值引用还是右值引用。
+        // 按输出顺序遍历对象成员，f(key, node)。ObjectType 可以是 Object 或 const Object
+        template <class ObjectType, class F>
+        void for_each_member(ObjectType &object, F &&f)
+        {
+#ifdef JSON_INTERN_KEYS
+            // 驻留模式下 map 按 id 排序，这里按字符串重新排序，保证输出与进程里驻留过哪些 key 无关
+            std::vector<decltype(&*object.begin())> members;
+            members.reserve(object.size());
+            for (auto &member : object)
+            {
+                members.push_back(&member);
+            }
+            std::sort(members.begin(), members.end(), [](auto lhs, auto rhs)
+                      { return lhs->first.str() < rhs->first.str(); });
+            for (auto member : members)
             {
-                using T = std::decay_t<decltype(arg)>; // 用于获取 arg 的实际类型 T，并去除可能的引用和修饰符。
-                if constexpr (std::is_same_v<T, Null>)
+                f(member->first, member->second);
+            }
+#else
+            for (auto &[key, node] : object)
+            {
+                f(key, node);
+            }
+#endif
+        }
+
+        void write_string(const String &str, std::string &out)
+        {
+            out += '"';
+            out += str;
+            out += '"';
+        }
+
+        void write(const Node &node, std::string &out);
+
+        // 输出 Array / Object：先写开括号，每个成员的值交给 write_child，最后写闭括号
+        template <class Container, class WriteChild>
+        void write_container(Container &container, std::string &out, WriteChild &&write_child)
+        {
+            constexpr bool is_object = std::is_same_v<std::remove_const_t<Container>, Object>;
+            out += is_object ? '{' : '[';
+            bool first = true;
+            auto write_member = [&](const Key *key, auto &child)
+            {
+                if (!first)
                 {
-                    return "null";
+                    out += ',';
                 }
-                else if constexpr (std::is_same_v<T, Bool>)
+                first = false;
+                if (key)
                 {
-                    return arg ? "true" : "false";
+                    write_string(*key, out);
+                    out += ':';
                 }
-                else if constexpr (std::is_same_v<T, Int>)
+                write_child(child);
+            };
+            if constexpr (is_object)
+            {
+                for_each_member(container, [&](const Key &key, auto &child)
+                                { write_member(&key, child); });
+            }
+            else
+            {
+                for (auto &child : container)
                 {
-                    return std::to_string(arg);
+                    write_member(nullptr, child);
                 }
-                else if constexpr (std::is_same_v<T, Float>)
+            }
+            out += is_object ? '}' : ']';
+        }
+
+        // 所有内容都追加到同一个 out 里，不为每一层构造临时字符串
+        void write(const Node &node, std::string &out)
+        {
+            // std::visit 是 C++17 引入的 std::variant 的访问器，用于根据 node.value 的类型执行不同的操作。
+            // 它接收一个 lambda 函数和一个 std::variant 类型的值 node.value，根据 node.value 的实际类型执行不同的逻辑。
+            std::visit(
+                [&](auto &&arg) //`&&`: 表示引用折叠，根据参数 `arg` 的实际类型来决定是左值引用还是右值引用。
+                {
+                    using T = std::decay_t<decltype(arg)>; // 用于获取 arg 的实际类型 T，并去除可能的引用和修饰符。
+                    if constexpr (std::is_same_v<T, Null>)
+                    {
+                        out += "null";
+                    }
+                    else if constexpr (std::is_same_v<T, Bool>)
+                    {
+                        out += arg ? "true" : "false";
+                    }
+                    else if constexpr (std::is_same_v<T, Int> || std::is_same_v<T, Float>)
+                    {
+                        out += std::to_string(arg);
+                    }
+                    else if constexpr (std::is_same_v<T, String>)
+                    {
+                        write_string(arg, out);
+                    }
+                    else
+                    {
+                        write_container(arg, out, [&](const Node &child)
+                                        { write(child, out); });
+                    }
+                },
+                node.value);
+        }
+
+        // 沿着 parent 找到保存文本的根，取出 link 缓存的文本。途中有容器重新生成过（version 对不上）或者没有缓存，
+        // 说明这段位置已经过期（例如节点被移出了原来的容器），返回空
+        auto resolve(const Node::Link &link) -> std::optional<std::string_view>
+        {
+            size_t offset = 0;
+            auto *l = &link;
+            while (!l->buffer)
+            {
+                auto *parent = l->parent.get();
+                if (!parent || !parent->cached || parent->version != l->parent_version)
                 {
-                    return std::to_string(arg);
+                    return std::nullopt;
                 }
-                else if constexpr (std::is_same_v<T, String>)
+                offset += l->offset;
+                l = parent;
+            }
+            return std::string_view{*l->buffer}.substr(l->offset + offset, link.length);
+        }
+
+        // 换父节点之前调用：位置是相对原来的父节点记录的，把文本复制一份自己保存，子节点的位置仍然有效
+        void materialize(Node::Link &link)
+        {
+            if (!link.cached || link.buffer)
+            {
+                return;
+            }
+            if (auto text = resolve(link))
+            {
+                link.buffer = std::make_shared<const std::string>(*text);
+                link.offset = 0;
+            }
+            else
+            {
+                link.cached = false;
+            }
+        }
+
+        void mark(Node::Link *link)
+        {
+            for (; link && !link->dirty; link = link->parent.get())
+            {
+                link->dirty = true;
+            }
+        }
+
+        // 没有修改过、有缓存的容器直接拼接文本，不往下走；其它容器重新序列化，并记下每个子节点在自己文本里的位置。
+        // 自己在父节点文本里的位置由调用方记录
+        void emit(Node &node, std::string &out)
+        {
+            auto *link = node.link.get();
+            if (link && !link->dirty && link->cached)
+            {
+                if (auto text = resolve(*link))
                 {
-                    return generate_string(arg);
+                    out += *text;
+                    return;
                 }
-                else if constexpr (std::is_same_v<T, Array>)
+            }
+            if (!is_container(node))
+            {
+                write(node, out);
+                if (link)
                 {
-                    return generate_array(arg);
+                    link->dirty = false;
                 }
-                else if constexpr (std::is_same_v<T, Object>)
+                return;
+            }
+            if (!link)
+            {
+                node.link = std::make_shared<Node::Link>();
+                link = node.link.get();
+            }
+            size_t start = out.size();
+            auto write_child = [&](Node &child)
+            {
+                size_t begin = out.size();
+                emit(child, out);
+                if (auto *child_link = child.link.get())
                 {
-                    return generate_object(arg);
+                    if (child_link->parent != node.link)
+                    {
+                        child_link->parent = node.link;
+                    }
+                    child_link->buffer.reset();
+                    child_link->offset = begin - start;
+                    child_link->length = out.size() - begin;
+                    child_link->parent_version = link->version + 1;
+                    child_link->cached = is_container(child) && child_link->length >= JsonGenerator::cache_threshold;
                 }
-            },
-            node.value);
+            };
+            if (auto array = std::get_if<Array>(&node.value))
+            {
+                write_container(*array, out, write_child);
+            }
+            else
+            {
+                write_container(std::get<Object>(node.value), out, write_child);
+            }
+            link->dirty = false;
+            link->version++;
+        }
     }
 
-    std::string JsonGenerator::generate_string(const String &str)
+    Node &Node::operator=(Node &&other)
     {
-        std::string json_str = "\"";
-        json_str += str;
-        json_str += '"';
-        return json_str;
+        if (this == &other)
+        {
+            return *this;
+        }
+        value = std::move(other.value);
+        if (!other.link)
+        {
+            touch();
+            return *this;
+        }
+        if (link && other.link->parent != link->parent)
+        {
+            materialize(*other.link);
+            other.link->parent = link->parent;
+        }
+        link = std::move(other.link);
+        mark(link->parent.get());
+        return *this;
     }
 
-    std::string JsonGenerator::generate_array(const Array &array) 
+    void Node::adopt(Node &child)
     {
-        std::string json_str = "[";
-        for (const auto &node : array)
+        if (!link)
         {
-            json_str += generate(node);
-            json_str += ',';
+            link = std::make_shared<Link>();
         }
-        if (!array.empty())
+        if (!child.link)
         {
-            json_str.pop_back(); // 如果数组不为空，移除最后一个元素后面的 ,，然后在字符串末尾添加 ]，表示 JSON 数组的结束。
+            child.link = std::make_shared<Link>();
         }
-        json_str += ']';
-        return json_str;
+        else if (child.link->parent != link)
+        {
+            materialize(*child.link);
+        }
+        child.link->parent = link;
+        touch();
     }
 
-    std::string JsonGenerator::generate_object(const Object &object)
+    void Node::attach(Node &child)
     {
-        std::string json_str = "{";
-        for (const auto &[key, node] : object)
+        if (!link)
+        {
+            link = std::make_shared<Link>();
+        }
+        if (!child.link)
+        {
+            // 内容没变，已经包含在这个节点的缓存里
+            child.link = std::make_shared<Link>();
+            child.link->parent = link;
+            child.link->dirty = false;
+        }
+        else if (child.link->parent != link)
         {
-            json_str += generate_string(key);
-            json_str += ':';
-            json_str += generate(node);
-            json_str += ',';
+            adopt(child); // 绕过接口放进来的节点
         }
+    }
 
-        if (!object.empty())
+    std::string JsonGenerator::generate(const Node &node)
+    {
+        // 用于根据 Node 对象生成对应的 JSON 字符串表示。
+        JSON_PHASE(Serialize);
+        std::string json_str;
+        write(node, json_str);
+        return json_str;
+    }
+
+    std::string JsonGenerator::generate_cached(Node &node)
+    {
+        JSON_PHASE(Serialize);
+        uint64_t version = node.link ? node.link->version : 0;
+        std::string json_str;
+        emit(node, json_str);
+        auto *link = node.link.get();
+        if (link && is_container(node) && link->version != version)
         {
-            json_str.pop_back();
+            // 重新生成过：文本保存在这里，子树里的缓存都是相对它的位置
+            link->cached = json_str.size() >= cache_threshold;
+            link->buffer = link->cached ? std::make_shared<const std::string>(json_str) : nullptr;
+            link->offset = 0;
+            link->length = json_str.size();
         }
         return json_str;
     }
 
-}
\ No newline at end of file
+    std::string JsonGenerator::generate_string(const String &str)
+    {
+        std::string json_str;
+        write_string(str, json_str);
+        return json_str;
+    }
+
+    std::string JsonGenerator::generate_array(const Array &array)
+    {
+        std::string json_str;
+        write_container(array, json_str, [&](const Node &child)
+                        { write(child, json_str); });
+        return json_str;
+    }
+
+    std::string JsonGenerator::generate_object(const Object &object)
+    {
+        std::string json_str;
+        write_container(object, json_str, [&](const Node &child)
+                        { write(child, json_str); });
+        return json_str;
+    }
+
+}
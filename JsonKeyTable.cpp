@@ -0,0 +1,55 @@
+#include "Json.hpp"
+#include <mutex>
+
+namespace json
+{
+    KeyTable::Storage &KeyTable::storage()
+    {
+        // 故意不释放：程序退出时其它静态对象的析构函数可能还持有驻留的 key
+        static Storage *storage = new Storage;
+        return *storage;
+    }
+
+    KeyTable::Entry KeyTable::intern(std::string_view key)
+    {
+        auto &[mutex, strings, ids] = storage();
+        {
+            // 绝大多数 key 已经驻留过，只需要读锁
+            std::shared_lock lock(mutex);
+            auto it = ids.find(key);
+            if (it != ids.end())
+            {
+                return {&strings[it->second], it->second};
+            }
+        }
+        std::unique_lock lock(mutex);
+        auto it = ids.find(key); // 拿写锁之前可能已经被别的线程插入
+        if (it != ids.end())
+        {
+            return {&strings[it->second], it->second};
+        }
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        const std::string &str = strings.emplace_back(key);
+        ids.emplace(std::string_view{str}, id);
+        return {&str, id};
+    }
+
+    std::optional<KeyTable::Entry> KeyTable::find(std::string_view key)
+    {
+        auto &[mutex, strings, ids] = storage();
+        std::shared_lock lock(mutex);
+        auto it = ids.find(key);
+        if (it == ids.end())
+        {
+            return {};
+        }
+        return Entry{&strings[it->second], it->second};
+    }
+
+    size_t KeyTable::size()
+    {
+        auto &table = storage();
+        std::shared_lock lock(table.mutex);
+        return table.strings.size();
+    }
+}
@@ -0,0 +1,449 @@
+#pragma once
+// 编译期 JSON：用 "..."_json 把内嵌在程序里的静态 JSON 文档在编译期完成校验和解析，
+// 结果是一张 static constexpr 的只读节点表，运行时不需要再调用 json::parser()。
+//     using namespace json::literals;
+//     constexpr auto defaults = R"({"port":8080,"hosts":["a","b"]})"_json;
+//     static_assert(defaults["port"].as_int() == 8080);
+// 格式错误的字面量会直接导致编译失败。
+#include "Json.hpp"
+#include <stdexcept>
+
+namespace json
+{
+    // 类类型的非类型模板参数（C++20），用来把字符串字面量带进模板
+    template <size_t N>
+    struct FixedString
+    {
+        char data[N]{};
+        constexpr FixedString(const char (&str)[N])
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                data[i] = str[i];
+            }
+        }
+        constexpr auto view() const -> std::string_view { return {data, N - 1}; }
+    };
+
+    // 节点表按先序排列：容器的第一个子节点紧跟在它后面，下一个兄弟节点在 index + span 处
+    struct StaticNode
+    {
+        size_t type = 0; // 与 Value 的 index() 一致：0 null, 1 bool, 2 int, 3 float, 4 string, 5 array, 6 object
+        Bool boolean = false;
+        Int integer = 0;
+        Float floating = 0;
+        std::string_view string; // 字符串的原始内容（与 JsonParser 一样不处理转义）；数字则是它的原始文本
+        std::string_view key;    // 作为对象成员时的 key
+        size_t count = 0;        // 直接子节点个数
+        size_t span = 1;         // 整棵子树占用的节点数（包括自己）
+    };
+
+    // 编译期解析器，语法与 JsonParser 相同，但遇到非法输入时抛异常，
+    // 在常量求值中抛异常就是编译错误。out 为 nullptr 时只校验并统计节点数。
+    class ConstexprParser
+    {
+    public:
+        constexpr explicit ConstexprParser(std::string_view json_str, StaticNode *out = nullptr) : json_str(json_str), out(out) {}
+
+        constexpr auto parse() -> size_t
+        {
+            parse_value({});
+            parse_whitespace();
+            if (pos != json_str.size())
+            {
+                throw std::runtime_error("json literal: trailing characters");
+            }
+            return size;
+        }
+
+    private:
+        constexpr void parse_whitespace()
+        {
+            while (pos < json_str.size() && (json_str[pos] == ' ' || json_str[pos] == '\t' || json_str[pos] == '\n' || json_str[pos] == '\r'))
+            {
+                pos++;
+            }
+        }
+
+        constexpr auto peek() const -> char
+        {
+            if (pos >= json_str.size())
+            {
+                throw std::runtime_error("json literal: unexpected end of input");
+            }
+            return json_str[pos];
+        }
+
+        constexpr void expect(std::string_view word)
+        {
+            if (json_str.substr(pos, word.size()) != word)
+            {
+                throw std::runtime_error("json literal: unexpected character");
+            }
+            pos += word.size();
+        }
+
+        constexpr auto emit(size_t type, std::string_view key) -> size_t
+        {
+            if (out)
+            {
+                out[size] = StaticNode{};
+                out[size].type = type;
+                out[size].key = key;
+            }
+            return size++;
+        }
+
+        constexpr auto parse_string() -> std::string_view
+        {
+            pos++; //"
+            size_t start = pos;
+            while (peek() != '"')
+            {
+                if (static_cast<unsigned char>(json_str[pos]) < 0x20)
+                {
+                    throw std::runtime_error("json literal: control character in string");
+                }
+                pos += json_str[pos] == '\\' ? 2 : 1;
+            }
+            pos++; //"
+            return json_str.substr(start, pos - 1 - start);
+        }
+
+        constexpr void parse_number(std::string_view key)
+        {
+            // 整数逐位累加，能放进 int64 的都保持 Int（与 parser() 的 std::stoll 一致）；
+            // 浮点数先把有效数字累加成尾数和十进制指数，见下面的缩放
+            size_t index = emit(2, key);
+            size_t start = pos;
+            bool negative = json_str[pos] == '-';
+            pos += negative;
+            if (pos >= json_str.size() || json_str[pos] < '0' || json_str[pos] > '9')
+            {
+                throw std::runtime_error("json literal: invalid number");
+            }
+            bool is_float = false;
+            uint64_t integer = 0; // 整数的绝对值，负数最多到 2^63
+            const uint64_t limit = negative ? uint64_t{1} << 63 : (uint64_t{1} << 63) - 1;
+            Int mantissa = 0;
+            int exponent = 0;
+            int digits = 0; // 有效数字个数，第一个非零数字之前的 0 不算
+            while (pos < json_str.size() && json_str[pos] >= '0' && json_str[pos] <= '9')
+            {
+                int digit = json_str[pos] - '0';
+                if (integer > (limit - digit) / 10)
+                {
+                    is_float = true; // 超出 int64 范围的整数按浮点数处理
+                }
+                else
+                {
+                    integer = integer * 10 + digit;
+                }
+                if (mantissa != 0 || digit != 0)
+                {
+                    if (digits++ < 18)
+                    {
+                        mantissa = mantissa * 10 + digit;
+                    }
+                    else
+                    {
+                        exponent++; // 超出 18 位的有效数字只记录数量级
+                    }
+                }
+                pos++;
+            }
+            if (pos < json_str.size() && json_str[pos] == '.')
+            {
+                is_float = true;
+                pos++;
+                if (pos >= json_str.size() || json_str[pos] < '0' || json_str[pos] > '9')
+                {
+                    throw std::runtime_error("json literal: invalid number");
+                }
+                while (pos < json_str.size() && json_str[pos] >= '0' && json_str[pos] <= '9')
+                {
+                    if (mantissa == 0 && json_str[pos] == '0')
+                    {
+                        exponent--; // 小数点后的前导 0 只影响指数
+                    }
+                    else if (digits++ < 18)
+                    {
+                        mantissa = mantissa * 10 + (json_str[pos] - '0');
+                        exponent--;
+                    }
+                    pos++;
+                }
+            }
+            if (pos < json_str.size() && (json_str[pos] == 'e' || json_str[pos] == 'E'))
+            {
+                is_float = true;
+                pos++;
+                bool negative_exponent = pos < json_str.size() && json_str[pos] == '-';
+                if (pos < json_str.size() && (json_str[pos] == '-' || json_str[pos] == '+'))
+                {
+                    pos++;
+                }
+                if (pos >= json_str.size() || json_str[pos] < '0' || json_str[pos] > '9')
+                {
+                    throw std::runtime_error("json literal: invalid number");
+                }
+                int value = 0;
+                while (pos < json_str.size() && json_str[pos] >= '0' && json_str[pos] <= '9')
+                {
+                    value = value * 10 + (json_str[pos++] - '0');
+                    if (value > 400)
+                    {
+                        throw std::runtime_error("json literal: exponent out of range");
+                    }
+                }
+                exponent += negative_exponent ? -value : value;
+            }
+            if (!out)
+            {
+                return;
+            }
+            out[index].string = json_str.substr(start, pos - start);
+            if (!is_float)
+            {
+                out[index].integer = static_cast<Int>(negative ? 0 - integer : integer); // 按模 2^64 转换，-2^63 也正确
+                return;
+            }
+            // 尾数不超过 2^53 且 |指数| <= 22 时，尾数和 10^|指数| 都能精确表示成 double，
+            // 一次乘除只舍入一次，结果与 std::stod 完全一致（Clinger 快速路径）。
+            // 超出这个范围时逐次乘除 10 只是近似值，可能差很多个 ulp（例如 1e-300），
+            // 所以 to_node() 不用这个值，而是对 string 里的原始文本调用 std::stod。
+            constexpr Float powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+            Float ret = static_cast<Float>(mantissa);
+            if (mantissa <= (Int{1} << 53) && exponent >= -22 && exponent <= 22)
+            {
+                ret = exponent >= 0 ? ret * powers[exponent] : ret / powers[-exponent];
+            }
+            else
+            {
+                for (; exponent > 0; exponent--)
+                {
+                    ret *= 10;
+                }
+                for (; exponent < 0; exponent++)
+                {
+                    ret /= 10;
+                }
+            }
+            out[index].type = 3;
+            out[index].floating = negative ? -ret : ret;
+        }
+
+        constexpr void parse_value(std::string_view key)
+        {
+            parse_whitespace();
+            switch (peek())
+            {
+            case 'n':
+                expect("null");
+                emit(0, key);
+                return;
+            case 't':
+            case 'f':
+            {
+                size_t index = emit(1, key);
+                bool value = peek() == 't';
+                expect(value ? "true" : "false");
+                if (out)
+                {
+                    out[index].boolean = value;
+                }
+                return;
+            }
+            case '"':
+            {
+                size_t index = emit(4, key);
+                auto str = parse_string();
+                if (out)
+                {
+                    out[index].string = str;
+                }
+                return;
+            }
+            case '[':
+            case '{':
+                parse_container(key);
+                return;
+            default:
+                parse_number(key);
+                return;
+            }
+        }
+
+        constexpr void parse_container(std::string_view key)
+        {
+            bool is_object = peek() == '{';
+            char close = is_object ? '}' : ']';
+            size_t index = emit(is_object ? 6 : 5, key);
+            size_t count = 0;
+            pos++; //[ 或 {
+            parse_whitespace();
+            if (peek() == close)
+            {
+                pos++;
+            }
+            else
+            {
+                while (true)
+                {
+                    std::string_view child_key;
+                    if (is_object)
+                    {
+                        parse_whitespace();
+                        if (peek() != '"')
+                        {
+                            throw std::runtime_error("json literal: object key must be a string");
+                        }
+                        child_key = parse_string();
+                        parse_whitespace();
+                        expect(":");
+                    }
+                    parse_value(child_key);
+                    count++;
+                    parse_whitespace();
+                    if (peek() == ',')
+                    {
+                        pos++;
+                        continue;
+                    }
+                    expect(std::string_view{&close, 1});
+                    break;
+                }
+            }
+            if (out)
+            {
+                out[index].count = count;
+                out[index].span = size - index;
+            }
+        }
+
+        std::string_view json_str;
+        StaticNode *out;
+        size_t pos = 0;
+        size_t size = 0;
+    };
+
+    // 指向节点表中某个节点的只读视图，所有访问都可以在编译期完成
+    class StaticView
+    {
+    public:
+        constexpr explicit StaticView(const StaticNode *node) : node(node) {}
+
+        constexpr auto type() const -> size_t { return node->type; }
+        constexpr auto is_null() const -> bool { return node->type == 0; }
+        constexpr auto as_bool() const -> Bool { return checked(1)->boolean; }
+        constexpr auto as_int() const -> Int { return checked(2)->integer; }
+        constexpr auto as_float() const -> Float { return node->type == 2 ? static_cast<Float>(node->integer) : checked(3)->floating; }
+        constexpr auto as_string() const -> std::string_view { return checked(4)->string; }
+        constexpr auto key() const -> std::string_view { return node->key; }
+        constexpr auto size() const -> size_t { return node->count; }
+
+        constexpr auto operator[](size_t index) const -> StaticView
+        {
+            if (node->type != 5 && node->type != 6)
+            {
+                throw std::runtime_error("not an array");
+            }
+            if (index >= node->count)
+            {
+                throw std::out_of_range("static json index out of range");
+            }
+            const StaticNode *child = node + 1;
+            for (; index > 0; index--)
+            {
+                child += child->span;
+            }
+            return StaticView{child};
+        }
+
+        constexpr auto operator[](std::string_view key) const -> StaticView
+        {
+            const StaticNode *child = checked(6) + 1;
+            for (size_t i = 0; i < node->count; i++, child += child->span)
+            {
+                if (child->key == key)
+                {
+                    return StaticView{child};
+                }
+            }
+            throw std::out_of_range("static json key not found");
+        }
+
+        // 需要可修改的副本时再转换成普通的 Node
+        auto to_node() const -> Node
+        {
+            switch (node->type)
+            {
+            case 1:
+                return Node{node->boolean};
+            case 2:
+                return Node{node->integer};
+            case 3:
+                return Node{std::stod(std::string{node->string})}; // 与 parser() 一样用 std::stod，保证结果一致
+            case 4:
+                return Node{String{node->string}};
+            case 5:
+            {
+                Array arr;
+                arr.reserve(node->count);
+                for (size_t i = 0; i < node->count; i++)
+                {
+                    arr.push_back((*this)[i].to_node());
+                }
+                return Node{arr};
+            }
+            case 6:
+            {
+                Object obj;
+                for (size_t i = 0; i < node->count; i++)
+                {
+                    auto child = (*this)[i];
+                    obj[String{child.key()}] = child.to_node();
+                }
+                return Node{obj};
+            }
+            default:
+                return Node{};
+            }
+        }
+
+    private:
+        constexpr auto checked(size_t type) const -> const StaticNode *
+        {
+            if (node->type != type)
+            {
+                throw std::runtime_error("static json type mismatch");
+            }
+            return node;
+        }
+
+        const StaticNode *node;
+    };
+
+    // 每个不同的字面量实例化一次，节点表是 static constexpr 的，编译器把它放在只读数据段
+    template <FixedString S>
+    struct StaticDocument
+    {
+        static constexpr size_t size = ConstexprParser{S.view()}.parse();
+        static constexpr std::array<StaticNode, size> nodes = []
+        {
+            std::array<StaticNode, size> ret{};
+            ConstexprParser{S.view(), ret.data()}.parse();
+            return ret;
+        }();
+    };
+
+    inline namespace literals
+    {
+        template <FixedString S>
+        constexpr auto operator""_json() -> StaticView
+        {
+            return StaticView{StaticDocument<S>::nodes.data()};
+        }
+    }
+}
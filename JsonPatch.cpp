@@ -0,0 +1,459 @@
+#include "Json.hpp"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <memory>
+
+namespace json
+{
+    // 把 JSON Pointer 拆成一段段 token，并还原 ~1 -> '/'、~0 -> '~'
+    std::vector<std::string> split_pointer(const std::string &path)
+    {
+        std::vector<std::string> tokens;
+        if (path.empty())
+        {
+            return tokens; // "" 表示整个文档
+        }
+        if (path[0] != '/')
+        {
+            throw std::runtime_error("invalid json pointer: " + path);
+        }
+        std::string token;
+        for (size_t i = 1; i <= path.size(); i++)
+        {
+            if (i == path.size() || path[i] == '/')
+            {
+                tokens.push_back(token);
+                token.clear();
+            }
+            else if (path[i] == '~')
+            {
+                if (i + 1 < path.size() && (path[i + 1] == '0' || path[i + 1] == '1'))
+                {
+                    token += path[++i] == '0' ? '~' : '/';
+                }
+                else
+                {
+                    throw std::runtime_error("invalid json pointer: " + path);
+                }
+            }
+            else
+            {
+                token += path[i];
+            }
+        }
+        return tokens;
+    }
+
+    namespace
+    {
+        std::string escape_token(const std::string &token)
+        {
+            std::string ret;
+            for (char c : token)
+            {
+                if (c == '~')
+                {
+                    ret += "~0";
+                }
+                else if (c == '/')
+                {
+                    ret += "~1";
+                }
+                else
+                {
+                    ret += c;
+                }
+            }
+            return ret;
+        }
+
+        // 数组下标只允许十进制数字，且除了 "0" 以外不能有前导 0
+        size_t parse_index(const std::string &token, size_t limit)
+        {
+            if (token.empty() || (token.size() > 1 && token[0] == '0'))
+            {
+                throw std::runtime_error("invalid array index: " + token);
+            }
+            size_t index = 0;
+            for (char c : token)
+            {
+                if (!std::isdigit(static_cast<unsigned char>(c)))
+                {
+                    throw std::runtime_error("invalid array index: " + token);
+                }
+                index = index * 10 + (c - '0');
+                if (index > limit)
+                {
+                    throw std::runtime_error("array index out of range: " + token);
+                }
+            }
+            return index;
+        }
+
+        // 沿着 tokens[0, count) 走到目标节点，每一层只做一次 map 查找或者下标访问，
+        // 所以一次操作的代价只和路径长度有关，和文档大小无关。
+        // modify 为 true 时沿途通过 Node::operator[] 访问，把路径上的节点接到各自的父节点上，
+        // 再把目标节点标记为已修改，标记会沿着父节点一直传播到根（见 Node::touch）。
+        Node &walk(Node &doc, const std::vector<std::string> &tokens, size_t count, bool modify)
+        {
+            Node *node = &doc;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (auto object = std::get_if<Object>(&node->value))
+                {
+                    auto it = find_key(*object, tokens[i]);
+                    if (it == object->end())
+                    {
+                        throw std::runtime_error("path not found: " + tokens[i]);
+                    }
+                    node = modify ? &(*node)[it->first] : &it->second;
+                }
+                else if (auto array = std::get_if<Array>(&node->value))
+                {
+                    size_t index = parse_index(tokens[i], array->size());
+                    if (index == array->size())
+                    {
+                        throw std::runtime_error("array index out of range: " + tokens[i]);
+                    }
+                    node = modify ? &(*node)[index] : &(*array)[index];
+                }
+                else
+                {
+                    throw std::runtime_error("path not found: " + tokens[i]);
+                }
+            }
+            if (modify)
+            {
+                node->touch();
+            }
+            return *node;
+        }
+
+        // 每个成功执行的修改都记一条撤销操作，apply 中途失败时倒序执行它们，
+        // 回滚的代价和已经执行的操作数成正比，不需要先拷贝整个文档
+        using UndoLog = std::vector<std::function<void()>>;
+
+        // value 只在真正插入时才被移走，路径不对等原因抛异常时调用方的值原样保留。
+        // back 不为空时，撤销这次 add 会把加进去的值移回 *back 而不是销毁它，
+        // move 操作靠它把值交还给 remove 的撤销操作，整个过程不拷贝子树
+        void add(Node &doc, const std::vector<std::string> &tokens, Node &&value, UndoLog &undo, std::shared_ptr<Node> back = nullptr)
+        {
+            auto take = [back](Node &node)
+            {
+                if (back)
+                {
+                    *back = std::move(node);
+                }
+            };
+            if (tokens.empty())
+            {
+                undo.push_back([&doc, take, old = std::move(doc)]() mutable
+                               {
+                                   take(doc);
+                                   doc = std::move(old); });
+                doc = std::move(value);
+                return;
+            }
+            Node &parent = walk(doc, tokens, tokens.size() - 1, true);
+            const std::string &last = tokens.back();
+            if (auto object = std::get_if<Object>(&parent.value))
+            {
+                auto it = find_key(*object, last);
+                if (it != object->end())
+                {
+                    // 覆盖已有的 key：撤销时放回旧值
+                    undo.push_back([&doc, tokens, take, old = std::move(it->second)]() mutable
+                                   {
+                                       Node &target = walk(doc, tokens, tokens.size(), true);
+                                       take(target);
+                                       target = std::move(old); });
+                    parent[it->first] = std::move(value);
+                }
+                else
+                {
+                    undo.push_back([&doc, tokens, take]()
+                                   {
+                                       auto &obj = std::get<Object>(walk(doc, tokens, tokens.size() - 1, true).value);
+                                       auto it = find_key(obj, tokens.back());
+                                       take(it->second);
+                                       obj.erase(it); });
+                    parent[Key{last}] = std::move(value);
+                }
+            }
+            else if (auto array = std::get_if<Array>(&parent.value))
+            {
+                size_t index = last == "-" ? array->size() : parse_index(last, array->size());
+                array->insert(array->begin() + index, std::move(value));
+                parent.adopt((*array)[index]);
+                undo.push_back([&doc, tokens, take, index]()
+                               {
+                                   auto &arr = std::get<Array>(walk(doc, tokens, tokens.size() - 1, true).value);
+                                   take(arr[index]);
+                                   arr.erase(arr.begin() + index); });
+            }
+            else
+            {
+                throw std::runtime_error("add: parent is not a container");
+            }
+        }
+
+        // 把目标节点移进返回的槽里，撤销时再从槽里移回原位。move 操作把槽里的值交给 add，
+        // 撤销 add 时又会还回这个槽（见 add 的 back），所以被删除的子树从头到尾都只移动、不拷贝
+        std::shared_ptr<Node> remove(Node &doc, const std::vector<std::string> &tokens, UndoLog &undo)
+        {
+            if (tokens.empty())
+            {
+                throw std::runtime_error("remove: cannot remove the whole document");
+            }
+            Node &parent = walk(doc, tokens, tokens.size() - 1, true);
+            const std::string &last = tokens.back();
+            if (auto object = std::get_if<Object>(&parent.value))
+            {
+                auto it = find_key(*object, last);
+                if (it == object->end())
+                {
+                    throw std::runtime_error("remove: path not found: " + last);
+                }
+                auto slot = std::make_shared<Node>(std::move(it->second));
+                object->erase(it);
+                undo.push_back([&doc, tokens, slot]()
+                               { walk(doc, tokens, tokens.size() - 1, true)[Key{tokens.back()}] = std::move(*slot); });
+                return slot;
+            }
+            if (auto array = std::get_if<Array>(&parent.value))
+            {
+                size_t index = parse_index(last, array->size());
+                if (index == array->size())
+                {
+                    throw std::runtime_error("remove: array index out of range: " + last);
+                }
+                auto slot = std::make_shared<Node>(std::move((*array)[index]));
+                array->erase(array->begin() + index);
+                undo.push_back([&doc, tokens, index, slot]()
+                               {
+                                   Node &parent = walk(doc, tokens, tokens.size() - 1, true);
+                                   auto &arr = std::get<Array>(parent.value);
+                                   arr.insert(arr.begin() + index, std::move(*slot));
+                                   parent.adopt(arr[index]); });
+                return slot;
+            }
+            throw std::runtime_error("remove: parent is not a container");
+        }
+
+        const std::string &member(const Object &op, const std::string &key)
+        {
+            auto it = find_key(op, key);
+            if (it == op.end() || !std::holds_alternative<String>(it->second.value))
+            {
+                throw std::runtime_error("patch operation missing \"" + key + "\"");
+            }
+            return std::get<String>(it->second.value);
+        }
+
+        const Node &member_value(const Object &op)
+        {
+            auto it = find_key(op, "value");
+            if (it == op.end())
+            {
+                throw std::runtime_error("patch operation missing \"value\"");
+            }
+            return it->second;
+        }
+
+        Node make_op(const std::string &op, const std::string &path)
+        {
+            Object obj;
+            obj["op"] = Node{op};
+            obj["path"] = Node{path};
+            return Node{obj};
+        }
+
+        Node make_op(const std::string &op, const std::string &path, const Node &value)
+        {
+            Node ret = make_op(op, path);
+            std::get<Object>(ret.value)["value"] = value;
+            return ret;
+        }
+
+        // 两边都是对象或都是数组时逐个成员递归，相同的部分不产生操作。不先对整棵子树做一次比较，
+        // 所以除了数组去掉相同前后缀时比较过的元素，每个节点只比较一次
+        void diff_node(const Node &from, const Node &to, const std::string &path, Array &ops)
+        {
+            auto from_object = std::get_if<Object>(&from.value);
+            auto to_object = std::get_if<Object>(&to.value);
+            if (from_object && to_object)
+            {
+                for (const auto &[key, node] : *from_object)
+                {
+                    if (to_object->find(key) == to_object->end())
+                    {
+                        ops.push_back(make_op("remove", path + "/" + escape_token(key)));
+                    }
+                }
+                for (const auto &[key, node] : *to_object)
+                {
+                    auto it = from_object->find(key);
+                    if (it == from_object->end())
+                    {
+                        ops.push_back(make_op("add", path + "/" + escape_token(key), node));
+                    }
+                    else
+                    {
+                        diff_node(it->second, node, path + "/" + escape_token(key), ops);
+                    }
+                }
+                return;
+            }
+            auto from_array = std::get_if<Array>(&from.value);
+            auto to_array = std::get_if<Array>(&to.value);
+            if (from_array && to_array)
+            {
+                // 先去掉相同的前缀和后缀，中间部分逐个比较，多出来的再 remove / add
+                size_t m = from_array->size(), n = to_array->size();
+                size_t prefix = 0;
+                while (prefix < m && prefix < n && (*from_array)[prefix] == (*to_array)[prefix])
+                {
+                    prefix++;
+                }
+                size_t suffix = 0;
+                while (suffix < m - prefix && suffix < n - prefix &&
+                       (*from_array)[m - 1 - suffix] == (*to_array)[n - 1 - suffix])
+                {
+                    suffix++;
+                }
+                size_t from_mid = m - prefix - suffix, to_mid = n - prefix - suffix;
+                size_t common = std::min(from_mid, to_mid);
+                for (size_t i = prefix; i < prefix + common; i++)
+                {
+                    diff_node((*from_array)[i], (*to_array)[i], path + "/" + std::to_string(i), ops);
+                }
+                for (size_t i = common; i < from_mid; i++)
+                {
+                    // 删除后后面的元素会前移，所以一直删同一个位置
+                    ops.push_back(make_op("remove", path + "/" + std::to_string(prefix + common)));
+                }
+                for (size_t i = common; i < to_mid; i++)
+                {
+                    ops.push_back(make_op("add", path + "/" + std::to_string(prefix + i), (*to_array)[prefix + i]));
+                }
+                return;
+            }
+            if (!(from == to))
+            {
+                ops.push_back(make_op("replace", path, to));
+            }
+        }
+    }
+
+    void JsonPatch::apply(Node &doc, const Node &patch)
+    {
+        // RFC 6902 要求整个 patch 要么全部生效，要么完全不生效：
+        // 任何一个操作失败时，按相反顺序撤销前面已经执行的操作，再把异常抛出去
+        auto ops = std::get_if<Array>(&patch.value);
+        if (!ops)
+        {
+            throw std::runtime_error("json patch must be an array");
+        }
+        UndoLog undo;
+        try
+        {
+            for (const auto &item : *ops)
+            {
+                auto op = std::get_if<Object>(&item.value);
+                if (!op)
+                {
+                    throw std::runtime_error("patch operation must be an object");
+                }
+                const std::string &name = member(*op, "op");
+                auto path = split_pointer(member(*op, "path"));
+                if (name == "add")
+                {
+                    add(doc, path, Node{member_value(*op)}, undo);
+                }
+                else if (name == "remove")
+                {
+                    remove(doc, path, undo);
+                }
+                else if (name == "replace")
+                {
+                    Node &target = walk(doc, path, path.size(), true);
+                    undo.push_back([&doc, path, old = std::move(target)]() mutable
+                                   { walk(doc, path, path.size(), true) = std::move(old); });
+                    target = member_value(*op);
+                }
+                else if (name == "move")
+                {
+                    auto from = split_pointer(member(*op, "from"));
+                    if (from.size() < path.size() && std::equal(from.begin(), from.end(), path.begin()))
+                    {
+                        throw std::runtime_error("move: cannot move a value into one of its children");
+                    }
+                    if (from != path)
+                    {
+                        auto removed = remove(doc, from, undo);
+                        add(doc, path, std::move(*removed), undo, removed);
+                    }
+                }
+                else if (name == "copy")
+                {
+                    auto from = split_pointer(member(*op, "from"));
+                    add(doc, path, Node{walk(doc, from, from.size(), false)}, undo);
+                }
+                else if (name == "test")
+                {
+                    if (!json_equal(walk(doc, path, path.size(), false).value, member_value(*op).value))
+                    {
+                        throw std::runtime_error("test failed: " + member(*op, "path"));
+                    }
+                }
+                else
+                {
+                    throw std::runtime_error("unknown patch operation: " + name);
+                }
+            }
+        }
+        catch (...)
+        {
+            for (auto it = undo.rbegin(); it != undo.rend(); ++it)
+            {
+                (*it)();
+            }
+            throw;
+        }
+    }
+
+    void JsonPatch::merge(Node &doc, const Node &merge_patch)
+    {
+        auto patch_object = std::get_if<Object>(&merge_patch.value);
+        if (!patch_object)
+        {
+            doc = merge_patch; // 不是对象时整个替换
+            return;
+        }
+        doc.touch();
+        if (!std::holds_alternative<Object>(doc.value))
+        {
+            doc.value = Object{};
+        }
+        auto &object = std::get<Object>(doc.value);
+        for (const auto &[key, node] : *patch_object)
+        {
+            if (std::holds_alternative<Null>(node.value))
+            {
+                object.erase(key);
+            }
+            else
+            {
+                merge(doc[key], node);
+            }
+        }
+    }
+
+    Node JsonPatch::diff(const Node &from, const Node &to)
+    {
+        Array ops;
+        diff_node(from, to, "", ops);
+        return Node{ops};
+    }
+}
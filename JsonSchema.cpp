@@ -0,0 +1,181 @@
+#include "Json.hpp"
+#include <stdexcept>
+
+namespace json
+{
+    namespace
+    {
+        uint8_t type_bits(const std::string &name)
+        {
+            if (name == "null")
+                return 1 << 0;
+            if (name == "boolean")
+                return 1 << 1;
+            if (name == "integer")
+                return 1 << 2 | 1 << 3; // 1.0 这样没有小数部分的 Float 也算整数，由 integral 再限制
+            if (name == "number")
+                return 1 << 2 | 1 << 3;
+            if (name == "string")
+                return 1 << 4;
+            if (name == "array")
+                return 1 << 5;
+            if (name == "object")
+                return 1 << 6;
+            throw std::runtime_error("schema: unknown type \"" + name + "\"");
+        }
+
+        Float number(const Node &node, const std::string &keyword)
+        {
+            if (auto i = std::get_if<Int>(&node.value))
+            {
+                return static_cast<Float>(*i);
+            }
+            if (auto f = std::get_if<Float>(&node.value))
+            {
+                return *f;
+            }
+            throw std::runtime_error("schema: \"" + keyword + "\" must be a number");
+        }
+
+        // property 表示这个 schema 是某个对象字段的子 schema，只有这时才允许 x-ignore
+        size_t compile(const Node &node, std::vector<Schema::State> &states, bool property)
+        {
+            size_t index = states.size();
+            states.emplace_back();
+            if (auto b = std::get_if<Bool>(&node.value))
+            {
+                if (!*b)
+                {
+                    states[index].types = 0; // false 表示拒绝任何值
+                }
+                return index; // true 表示不做任何限制
+            }
+            auto object = std::get_if<Object>(&node.value);
+            if (!object)
+            {
+                throw std::runtime_error("schema: a schema must be an object or a boolean");
+            }
+            // 注意 states 在递归中可能扩容，所以始终通过下标访问当前状态
+            for (const auto &[key, value] : *object)
+            {
+                const std::string &keyword = key;
+                if (keyword == "type")
+                {
+                    uint8_t types = 0;
+                    bool number = false;
+                    if (auto name = std::get_if<String>(&value.value))
+                    {
+                        types = type_bits(*name);
+                        number = *name == "number";
+                    }
+                    else if (auto names = std::get_if<Array>(&value.value))
+                    {
+                        for (const auto &name : *names)
+                        {
+                            if (!std::holds_alternative<String>(name.value))
+                            {
+                                throw std::runtime_error("schema: \"type\" must be a string or an array of strings");
+                            }
+                            types |= type_bits(std::get<String>(name.value));
+                            number = number || std::get<String>(name.value) == "number";
+                        }
+                    }
+                    else
+                    {
+                        throw std::runtime_error("schema: \"type\" must be a string or an array of strings");
+                    }
+                    states[index].types = types;
+                    states[index].integral = (types & 1 << 3) && !number; // 只写了 integer 没写 number
+                }
+                else if (keyword == "required")
+                {
+                    auto names = std::get_if<Array>(&value.value);
+                    if (!names)
+                    {
+                        throw std::runtime_error("schema: \"required\" must be an array of strings");
+                    }
+                    for (const auto &name : *names)
+                    {
+                        if (!std::holds_alternative<String>(name.value))
+                        {
+                            throw std::runtime_error("schema: \"required\" must be an array of strings");
+                        }
+                        states[index].required.push_back(std::get<String>(name.value));
+                    }
+                }
+                else if (keyword == "properties")
+                {
+                    auto properties = std::get_if<Object>(&value.value);
+                    if (!properties)
+                    {
+                        throw std::runtime_error("schema: \"properties\" must be an object");
+                    }
+                    for (const auto &[name, child] : *properties)
+                    {
+                        size_t child_index = compile(child, states, true);
+                        states[index].properties[name] = child_index;
+                    }
+                }
+                else if (keyword == "enum")
+                {
+                    auto values = std::get_if<Array>(&value.value);
+                    if (!values || values->empty())
+                    {
+                        throw std::runtime_error("schema: \"enum\" must be a non-empty array");
+                    }
+                    states[index].enumeration = *values;
+                }
+                else if (keyword == "minimum")
+                {
+                    states[index].minimum = number(value, keyword);
+                }
+                else if (keyword == "maximum")
+                {
+                    states[index].maximum = number(value, keyword);
+                }
+                else if (keyword == "maxLength")
+                {
+                    auto length = std::get_if<Int>(&value.value);
+                    if (!length || *length < 0)
+                    {
+                        throw std::runtime_error("schema: \"maxLength\" must be a non-negative integer");
+                    }
+                    states[index].max_length = static_cast<size_t>(*length);
+                }
+                else if (keyword == "items")
+                {
+                    size_t child_index = compile(value, states, false);
+                    states[index].items = child_index;
+                }
+                else if (keyword == "x-ignore")
+                {
+                    auto ignored = std::get_if<Bool>(&value.value);
+                    if (!ignored)
+                    {
+                        throw std::runtime_error("schema: \"x-ignore\" must be a boolean");
+                    }
+                    if (!property)
+                    {
+                        // 数组元素和根节点没法只跳过不构造，直接拒绝，避免写了却不生效
+                        throw std::runtime_error("schema: \"x-ignore\" is only supported under \"properties\"");
+                    }
+                    states[index].ignored = *ignored;
+                }
+                else if (keyword != "$schema" && keyword != "$id" && keyword != "title" && keyword != "description" &&
+                         keyword != "default" && keyword != "examples")
+                {
+                    // 不认识的校验关键字直接报错，避免以为校验了其实没有
+                    throw std::runtime_error("schema: unsupported keyword \"" + keyword + "\"");
+                }
+            }
+            return index;
+        }
+    }
+
+    Schema compile_schema(const Node &schema)
+    {
+        Schema ret;
+        compile(schema, ret.states, false);
+        return ret;
+    }
+}
@@ -0,0 +1,66 @@
+#include "Json.hpp"
+
+namespace json
+{
+    namespace
+    {
+        thread_local Stats current_stats;
+        thread_local std::array<int, Stats::PhaseCount> active_phases{}; // 每个阶段当前的嵌套层数
+    }
+
+    Stats &stats()
+    {
+        return current_stats;
+    }
+
+    void reset_stats()
+    {
+        current_stats = Stats{};
+    }
+
+    PhaseTimer::PhaseTimer(Stats::Phase phase) : phase(phase)
+    {
+        if (active_phases[phase]++ == 0)
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    PhaseTimer::~PhaseTimer()
+    {
+        if (--active_phases[phase] == 0)
+        {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            current_stats.phase_ns[phase] += ns;
+            JSON_PROBE(phase_done, ns);
+        }
+    }
+
+    Node Stats::to_node() const
+    {
+        static const char *node_names[] = {"null", "bool", "int", "float", "string", "array", "object"};
+        static const char *phase_names[] = {"scan", "parse", "build", "serialize"};
+        Object node_count;
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            node_count[node_names[i]] = Node{static_cast<Int>(nodes[i])};
+        }
+        Object phase_time;
+        for (size_t i = 0; i < phase_ns.size(); i++)
+        {
+            phase_time[phase_names[i]] = Node{static_cast<Int>(phase_ns[i])};
+        }
+        Object obj;
+        obj["bytes_scanned"] = Node{static_cast<Int>(bytes_scanned)};
+        obj["nodes"] = Node{node_count};
+        obj["max_depth"] = Node{static_cast<Int>(max_depth)};
+        obj["strings"] = Node{static_cast<Int>(strings)};
+        obj["escapes"] = Node{static_cast<Int>(escapes)};
+        obj["number_fast_path"] = Node{static_cast<Int>(number_fast_path)};
+        obj["number_fallback"] = Node{static_cast<Int>(number_fallback)};
+        obj["allocations"] = Node{static_cast<Int>(allocations)};
+        obj["bytes_allocated"] = Node{static_cast<Int>(bytes_allocated)};
+        obj["phase_ns"] = Node{phase_time};
+        return Node{obj};
+    }
+}
@@ -1,4 +1,6 @@
 #include "Json.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace json
 {
@@ -44,12 +46,27 @@ namespace json
     std::optional<Value> JsonParser::parse_number()
     {
         // 解析 JSON 字符串中的数字（可能为整数或浮点数）
+        JSON_PHASE(Scan);
         size_t endpos = pos;
+        bool all_digits = true;
         while (endpos < json_str.size() && (std::isdigit(json_str[endpos]) || json_str[endpos] == 'e' || json_str[endpos] == '.'))
         {
             // 这是一个 while 循环，用于找到数字的结束位置 endpos
+            all_digits = all_digits && std::isdigit(json_str[endpos]);
             endpos++;
         }
+        if (all_digits && endpos > pos && endpos - pos <= 18)
+        {
+            // 快速路径：不超过 18 位的整数不会溢出 int64_t，直接逐位累加，不需要构造 std::string
+            Int ret = 0;
+            for (; pos < endpos; pos++)
+            {
+                ret = ret * 10 + (json_str[pos] - '0');
+            }
+            JSON_STAT(number_fast_path++);
+            return ret;
+        }
+        JSON_STAT(number_fallback++);
         std::string number = std::string{json_str.substr(pos, endpos - pos)};
         pos = endpos;
         static auto is_Float = [](std::string &number)
@@ -77,7 +94,7 @@ namespace json
         {
             try
             {
-                Int ret = std::stoi(number);
+                Int ret = std::stoll(number); // 19 位的 int64 也能转换
                 return ret;
             }
             catch (...)
@@ -89,14 +106,27 @@ namespace json
 
     std::optional<Value> JsonParser::parse_string()
     {
+        JSON_PHASE(Scan);
         pos++; //"
         size_t endpos = pos;
-        while (pos < json_str.size() && json_str[endpos] != '"')
+        while (endpos < json_str.size() && json_str[endpos] != '"')
         {
+            if (json_str[endpos] == '\\')
+            {
+                // 转义序列整体跳过：\\ 只算一次转义，\" 也不会被当成字符串结束（内容仍保留原始文本）
+                JSON_STAT(escapes++);
+                endpos++;
+            }
             endpos++;
         }
+        endpos = std::min(endpos, json_str.size()); // 末尾是单独的反斜杠时不要越界
         std::string str = std::string{json_str.substr(pos, endpos - pos)};
         pos = endpos + 1;
+        JSON_STAT(strings++);
+        JSON_STATS_ONLY(if (str.capacity() > std::string{}.capacity()) {
+            JSON_STAT(allocations++);
+            JSON_STAT(bytes_allocated += str.capacity() + 1);
+        })
         return str;
     }
 
@@ -104,10 +134,30 @@ namespace json
     {
         pos++; //[
         Array arr;
+        JSON_STATS_ONLY(++depth; JSON_STAT(max_depth = std::max<uint64_t>(stats().max_depth, depth));)
+        size_t parent = state;
         while (pos < json_str.size() && json_str[pos] != ']')
         {
+            if (schema)
+            {
+                state = parent == Schema::any ? Schema::any : schema->states[parent].items;
+            }
             auto value = parse_value();
-            arr.push_back(value.value());
+            if (!value)
+            {
+                // 子元素解析失败（或者没有通过 schema 校验），整个数组都失败
+                JSON_STATS_ONLY(--depth;)
+                return {};
+            }
+            {
+                JSON_PHASE(Build);
+                JSON_STAT(nodes[value.value().index()]++);
+                JSON_STATS_ONLY(if (arr.size() == arr.capacity()) {
+                    JSON_STAT(allocations++);
+                    JSON_STAT(bytes_allocated += std::max<size_t>(1, arr.capacity() * 2) * sizeof(Node));
+                })
+                arr.push_back(value.value());
+            }
             parse_whitespace();
             if (pos < json_str.size() && json_str[pos] == ',')
             {
@@ -116,6 +166,8 @@ namespace json
             parse_whitespace();
         }
         pos++; //]
+        state = parent;
+        JSON_STATS_ONLY(--depth;)
         return arr;
     }
 
@@ -123,15 +175,21 @@ namespace json
     {
         pos++; //{ ：将 pos 向前移动一位，跳过当前位置的 { 字符，因为 JSON 对象的开始应该是 {。
         Object obj;
+        JSON_STATS_ONLY(++depth; JSON_STAT(max_depth = std::max<uint64_t>(stats().max_depth, depth));)
+        size_t parent = state;
+        const Schema::State *rules = schema && parent != Schema::any ? &schema->states[parent] : nullptr;
+        std::vector<bool> seen(rules ? rules->required.size() : 0); // 记录 required 里的 key 是否出现过
         while (pos < json_str.size() && json_str[pos] != '}')
         {
+            state = Schema::any;      // key 本身不参与校验
             auto key = parse_value(); // 解析键值
             parse_whitespace();       // 跳过可能的空格
 
-            if (!std::holds_alternative<String>(key.value()))
+            if (!key || !std::holds_alternative<String>(*key))
             {
                 // std::holds_alternative 是 C++ <variant> 头文件中提供的函数模板，用于检查 std::variant 是否包含特定类型的值。它是 std::variant 类型的成员函数，也可以作为全局函数使用。
                 // 检查解析出的键是否是 String 类型。如果不是 String 类型，则返回空的 std::optional<Value>，表示解析失败。
+                JSON_STATS_ONLY(--depth;)
                 return {};
             }
 
@@ -141,8 +199,42 @@ namespace json
             }
 
             parse_whitespace();
+            if (rules)
+            {
+                const auto &name = std::get<String>(*key);
+                auto it = rules->properties.find(name);
+                state = it == rules->properties.end() ? Schema::any : it->second;
+                auto required = std::find(rules->required.begin(), rules->required.end(), name);
+                if (required != rules->required.end())
+                {
+                    seen[required - rules->required.begin()] = true;
+                }
+                if (state != Schema::any && schema->states[state].ignored)
+                {
+                    // schema 标记为忽略的字段：只扫描跳过，不构造 Node
+                    skip_value();
+                    parse_whitespace();
+                    if (pos < json_str.size() && json_str[pos] == ',')
+                    {
+                        pos++;
+                    }
+                    parse_whitespace();
+                    continue;
+                }
+            }
             auto val = parse_value(); // 解析value
-            obj[std::get<String>(key.value())] = val.value();
+            if (!val)
+            {
+                JSON_STATS_ONLY(--depth;)
+                return {};
+            }
+            {
+                JSON_PHASE(Build);
+                JSON_STAT(nodes[val.value().index()]++);
+                JSON_STAT(allocations++); // map 每插入一个 key 分配一个红黑树节点
+                JSON_STAT(bytes_allocated += sizeof(Object::value_type) + 4 * sizeof(void *));
+                obj[std::get<String>(key.value())] = val.value();
+            }
             parse_whitespace();
             if (pos < json_str.size() && json_str[pos] == ',')
             {
@@ -151,6 +243,16 @@ namespace json
             parse_whitespace();
         }
         pos++; //}
+        state = parent;
+        JSON_STATS_ONLY(--depth;)
+        for (size_t i = 0; i < seen.size(); i++)
+        {
+            if (!seen[i])
+            {
+                error = "schema: missing required key \"" + rules->required[i] + "\" before offset " + std::to_string(pos);
+                return {};
+            }
+        }
         return obj;
     }
 
@@ -158,35 +260,111 @@ namespace json
     {
         // parse_value() 函数根据当前 pos 所指向的字符，选择调用上述各个解析函数，以解析并返回对应的 JSON 值。
         parse_whitespace();
+        if (schema && !check_type())
+        {
+            return {}; // 根据第一个字符就能判断类型，不符合 schema 时不再往下解析
+        }
+        std::optional<Value> value;
         switch (json_str[pos])
         {
         case 'n':
-            return parse_null();
+            value = parse_null();
+            break;
         case 't':
-            return parse_true();
+            value = parse_true();
+            break;
         case 'f':
-            return parse_false();
+            value = parse_false();
+            break;
         case '"':
-            return parse_string();
+            value = parse_string();
+            break;
         case '[':
-            return parse_array();
+            value = parse_array();
+            break;
         case '{':
-            return parse_object();
+            value = parse_object();
+            break;
 
         default:
-            return parse_number();
+            value = parse_number();
+            break;
+        }
+        if (value && schema && !check_value(*value))
+        {
+            return {};
+        }
+        return value;
+    }
+
+    void JsonParser::skip_value()
+    {
+        // 只做词法扫描：记录括号层数并跳过字符串（包括里面的转义），不构造任何值
+        parse_whitespace();
+        size_t level = 0;
+        bool in_string = false;
+        for (; pos < json_str.size(); pos++)
+        {
+            char c = json_str[pos];
+            if (in_string)
+            {
+                if (c == '\\')
+                {
+                    pos++;
+                }
+                else if (c == '"')
+                {
+                    in_string = false;
+                    if (level == 0)
+                    {
+                        pos++;
+                        return;
+                    }
+                }
+            }
+            else if (c == '"')
+            {
+                in_string = true;
+            }
+            else if (c == '[' || c == '{')
+            {
+                level++;
+            }
+            else if (c == ']' || c == '}')
+            {
+                if (level == 0)
+                {
+                    return; // 标量后面紧跟着外层的结束符
+                }
+                if (--level == 0)
+                {
+                    pos++;
+                    return;
+                }
+            }
+            else if (level == 0 && (c == ',' || std::isspace(static_cast<unsigned char>(c))))
+            {
+                return;
+            }
         }
     }
 
     std::optional<Node> JsonParser::parse()
     {
         // parse() 函数是解析器的入口函数，调用 parse_value() 来解析 JSON 字符串的根值，并将解析结果封装在 std::optional<Node> 中返回。如果解析成功，会创建一个 Node 对象来包装解析出的值。
+        JSON_PHASE(Parse);
+        JSON_PROBE(parse_start, json_str.size());
+        JSON_STATS_ONLY(size_t start = pos;)
+        state = schema ? 0 : Schema::any;
         parse_whitespace();
         auto value = parse_value();
+        JSON_STAT(bytes_scanned += pos - start);
+        JSON_PROBE(parse_done, pos);
         if (!value)
         {
             return {};
         }
+        JSON_STAT(nodes[value->index()]++);
         // 如果解析成功得到了一个有效的值 value，则创建一个 Node 对象，将 *value（value 的值）作为参数传递给 Node 对象的构造函数
         return Node{*value};
         // 为什么是花括号？
@@ -198,4 +376,140 @@ namespace json
         //  使用圆括号进行构造是传统的直接初始化方式，它也是 C++ 的标准语法之一。
         //  圆括号构造在某些情况下可能会允许隐式类型转换或窄化，因此在某些情况下可能会导致不符合预期的行为。
     }
-}
\ No newline at end of file
+
+    bool json_equal(const Value &lhs, const Value &rhs)
+    {
+        auto number = [](const Value &value) -> std::optional<Float>
+        {
+            if (auto i = std::get_if<Int>(&value))
+            {
+                return static_cast<Float>(*i);
+            }
+            if (auto f = std::get_if<Float>(&value))
+            {
+                return *f;
+            }
+            return {};
+        };
+        auto l = number(lhs), r = number(rhs);
+        if (l || r)
+        {
+            if (std::holds_alternative<Int>(lhs) && std::holds_alternative<Int>(rhs))
+            {
+                return std::get<Int>(lhs) == std::get<Int>(rhs); // 两个整数直接比较，不经过 double 丢精度
+            }
+            return l && r && *l == *r;
+        }
+        if (auto la = std::get_if<Array>(&lhs))
+        {
+            auto ra = std::get_if<Array>(&rhs);
+            return ra && std::equal(la->begin(), la->end(), ra->begin(), ra->end(), [](const Node &a, const Node &b)
+                                    { return json_equal(a.value, b.value); });
+        }
+        if (auto lo = std::get_if<Object>(&lhs))
+        {
+            auto ro = std::get_if<Object>(&rhs);
+            return ro && std::equal(lo->begin(), lo->end(), ro->begin(), ro->end(),
+                                    [](const auto &a, const auto &b)
+                                    { return a.first == b.first && json_equal(a.second.value, b.second.value); });
+        }
+        return lhs == rhs;
+    }
+
+    // schema 的校验在解析过程中完成；JsonSchema.cpp 只负责把 schema 文档编译成状态表，
+    // 不用 schema 的程序不需要链接它
+    bool JsonParser::check_type()
+    {
+        if (state == Schema::any || pos >= json_str.size())
+        {
+            return true;
+        }
+        uint8_t types = schema->states[state].types;
+        uint8_t bits;
+        switch (json_str[pos])
+        {
+        case 'n':
+            bits = 1 << 0;
+            break;
+        case 't':
+        case 'f':
+            bits = 1 << 1;
+            break;
+        case '"':
+            bits = 1 << 4;
+            break;
+        case '[':
+            bits = 1 << 5;
+            break;
+        case '{':
+            bits = 1 << 6;
+            break;
+        default:
+            bits = 1 << 2 | 1 << 3; // 数字要解析完才知道是 Int 还是 Float，交给 check_value
+            break;
+        }
+        if (types & bits)
+        {
+            return true;
+        }
+        error = "schema: unexpected type at offset " + std::to_string(pos);
+        return false;
+    }
+
+    bool JsonParser::check_value(const Value &value)
+    {
+        if (state == Schema::any)
+        {
+            return true;
+        }
+        const auto &rules = schema->states[state];
+        size_t start = pos;
+        auto fail = [&](const std::string &reason)
+        {
+            error = "schema: " + reason + " before offset " + std::to_string(start);
+            return false;
+        };
+        if (!(rules.types & (1 << value.index())))
+        {
+            return fail("unexpected type");
+        }
+        if (auto f = std::get_if<Float>(&value); f && rules.integral && std::trunc(*f) != *f)
+        {
+            return fail("expected an integer");
+        }
+        if (!rules.enumeration.empty() &&
+            std::none_of(rules.enumeration.begin(), rules.enumeration.end(), [&](const Node &option)
+                         { return json_equal(option.value, value); }))
+        {
+            return fail("value not in enum");
+        }
+        if (rules.minimum || rules.maximum)
+        {
+            std::optional<Float> number;
+            if (auto i = std::get_if<Int>(&value))
+            {
+                number = static_cast<Float>(*i);
+            }
+            else if (auto f = std::get_if<Float>(&value))
+            {
+                number = *f;
+            }
+            if (number && rules.minimum && *number < *rules.minimum)
+            {
+                return fail("value below minimum");
+            }
+            if (number && rules.maximum && *number > *rules.maximum)
+            {
+                return fail("value above maximum");
+            }
+        }
+        if (rules.max_length)
+        {
+            if (auto str = std::get_if<String>(&value); str && str->size() > *rules.max_length)
+            {
+                return fail("string longer than maxLength");
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,71 @@
+// g++ -std=c++20 test_array_reader.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonSchema.cpp JsonPatch.cpp JsonArrayReader.cpp -o test_array_reader
+#include "Json.hpp"
+#include <cassert>
+using namespace json;
+
+// 读出全部元素，各自生成文本
+static std::vector<std::string> read_all(const std::string &text, const std::string &path = "", size_t buffer_size = 64 * 1024)
+{
+    std::istringstream in(text);
+    std::vector<std::string> ret;
+    for (auto &node : ArrayReader{in, path, buffer_size})
+    {
+        ret.push_back(generate(node));
+    }
+    return ret;
+}
+
+static bool throws(const std::string &text, const std::string &path = "")
+{
+    try
+    {
+        read_all(text, path);
+    }
+    catch (std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    // 顶层数组
+    assert((read_all("[1,true,null,\"x\"]") == std::vector<std::string>{"1", "true", "null", "\"x\""}));
+
+    // path 指向嵌套的数组，路径之外的值（包括里面的括号和字符串）只跳过
+    const std::string doc = R"({"meta":{"skip":[1,{"x":"]"}],"note":"}{,"},
+                                "data":{"rows":[{"id":1,"s":"a]b"},{"id":2,"s":"c}d"},{"id":3,"s":"e,f"},{"id":4,"s":"g\"h"}]},
+                                "list":[[0],[5,6]]})";
+    std::vector<std::string> rows = {R"({"id":1,"s":"a]b"})", R"({"id":2,"s":"c}d"})", R"({"id":3,"s":"e,f"})",
+                                     R"({"id":4,"s":"g\"h"})"};
+    assert(read_all(doc, "/data/rows") == rows);
+    assert((read_all(doc, "/list/1") == std::vector<std::string>{"5", "6"}));
+
+    // 缓冲区只有 1 字节，每个元素都跨越多次补充
+    assert(read_all(doc, "/data/rows", 1) == rows);
+
+    // 空数组，以及元素之间的空白
+    assert(read_all("[]").empty());
+    assert(read_all(R"({"a":[]})", "/a", 1).empty());
+    assert((read_all(" [ 1 ,\n2\t] ", "", 1) == std::vector<std::string>{"1", "2"}));
+
+    // next() 可以单独使用，读完之后一直返回空
+    std::istringstream in("[[1,2],{\"k\":\"v\"}]");
+    ArrayReader reader{in};
+    assert(generate(*reader.next()) == "[1,2]");
+    assert(generate(*reader.next()) == R"({"k":"v"})");
+    assert(!reader.next() && !reader.next());
+
+    // 错误输入
+    assert(throws(doc, "/missing"));
+    assert(throws(doc, "/list/9"));
+    assert(throws(doc, "/meta/note"));
+    assert(throws(doc, "/list/x"));
+    assert(throws("[1 2]"));
+    assert(throws("[1,2"));
+    assert(throws("[1,tru]"));
+    assert(throws("{\"a\":1}"));
+
+    std::cout << "test_array_reader ok" << std::endl;
+}
@@ -0,0 +1,162 @@
+// g++ -std=c++20 test_cache.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonSchema.cpp JsonPatch.cpp -o test_cache
+#include "Json.hpp"
+#include <cassert>
+#include <thread>
+using namespace json;
+
+static const char *text = R"({"name":"zyl_json_parser","version":1,"description":"incremental serialization test document",)"
+                          R"("configurations":[{"type":"cppdbg","request":"launch","program":"a.out","stopAtEntry":false},)"
+                          R"({"type":"cppdbg","request":"attach","program":"b.out","processId":1234}],)"
+                          R"("port":8080,"hosts":["alpha.example.com","beta.example.com","gamma.example.com"]})";
+
+// 所有节点自己保存的文本的总长度。子树的缓存只是在根节点文本里的位置，所以等于整个文档的长度
+static size_t buffered_bytes(const Node &node)
+{
+    size_t ret = node.link && node.link->buffer ? node.link->buffer->size() : 0;
+    if (auto array = std::get_if<Array>(&node.value))
+    {
+        for (const auto &child : *array)
+        {
+            ret += buffered_bytes(child);
+        }
+    }
+    else if (auto object = std::get_if<Object>(&node.value))
+    {
+        for (const auto &[key, child] : *object)
+        {
+            ret += buffered_bytes(child);
+        }
+    }
+    return ret;
+}
+
+// 增量生成的结果必须和完整重新生成一样
+static std::string check(Node &x)
+{
+    auto incremental = generate_cached(x);
+    assert(incremental == generate(x));
+    return incremental;
+}
+
+int main()
+{
+    auto x = parser(text).value();
+    auto first = check(x);
+    assert(x.link && x.link->buffer);
+    assert(buffered_bytes(x) == first.size());
+    auto *buffer = x.link->buffer.get();
+    assert(check(x) == first && x.link->buffer.get() == buffer); // 没有修改时整篇来自缓存，不重新生成
+
+    // 只有修改路径上的容器重新生成，旁边的子树直接拼接
+    auto &configurations = x["configurations"];
+    auto &launch = configurations[0];
+    auto &attach = configurations[1];
+    uint64_t launch_version = launch.link->version;
+    uint64_t attach_version = attach.link->version;
+    launch["program"] = Node{String{"c.out"}};
+    assert(check(x).find("c.out") != std::string::npos);
+    assert(launch.link->version == launch_version + 1 && attach.link->version == attach_version);
+    assert(buffered_bytes(x) == generate(x).size());
+
+    // 保留下来的容器引用，生成之后再修改
+    generate_cached(x);
+    configurations.push(Node{true});
+    auto pushed = check(x);
+    assert(pushed.find(",true]") != std::string::npos);
+
+    // 保留下来的标量引用
+    auto &port = x["port"];
+    generate_cached(x);
+    port = Node{Int{9090}};
+    assert(check(x).find("\"port\":9090") != std::string::npos);
+
+    // const 查找不分配 link、不标记修改
+    const Node &cx = x;
+    buffer = x.link->buffer.get();
+    assert(std::get<String>(cx["configurations"][1]["type"].value) == "cppdbg");
+    assert(!cx["configurations"][1]["type"].link);
+    check(x);
+    assert(x.link->buffer.get() == buffer);
+
+    // 绕过接口直接改 value 后 touch 被改的容器
+    auto &hosts = const_cast<Node &>(cx["hosts"]);
+    std::get<Array>(hosts.value).pop_back();
+    hosts.touch();
+    assert(check(x).find("gamma") == std::string::npos);
+    std::get<Array>(hosts.value).push_back(Node{String{"delta.example.com"}});
+    hosts.adopt(std::get<Array>(hosts.value).back());
+    assert(check(x).find("delta") != std::string::npos);
+
+    // const 查找找不到 key 时抛异常，不会插入
+    bool threw = false;
+    try
+    {
+        cx["missing"];
+    }
+    catch (std::out_of_range &)
+    {
+        threw = true;
+    }
+    assert(threw && !std::get<Object>(x.value).count("missing"));
+
+    // 拷贝不带 link，vector 扩容时移动的子节点保留 link
+    Node copy = x;
+    assert(!copy.link && generate(copy) == generate(x));
+    Node list{Array{}};
+    list.push(x);
+    generate_cached(list);
+    auto *element = std::get<Array>(list.value)[0].link.get();
+    assert(element && element->cached);
+    for (int i = 0; i < 16; i++)
+    {
+        list.push(Node{Int{i}});
+    }
+    assert(std::get<Array>(list.value)[0].link.get() == element);
+    check(list);
+
+    // 移出原来的树的子树：原来的树重新生成后，它记的位置作废，不会输出别的文本
+    auto y = parser(text).value();
+    generate_cached(y);
+    Node moved = std::move(std::get<Object>(y.value)["configurations"]);
+    y.touch();
+    check(y);
+    check(moved);
+    Node z{Object{}};
+    generate_cached(z);
+    z["moved"] = std::move(moved);
+    auto &kept = z["moved"];
+    check(z);
+    kept.push(Node{Int{1}});
+    assert(check(z).find(",1]") != std::string::npos);
+
+    // JsonPatch 修改后的结果
+    apply_patch(x, parser(R"([{"op":"replace","path":"/configurations/1/program","value":"d.out"},)"
+                          R"({"op":"remove","path":"/configurations/0"},)"
+                          R"({"op":"move","from":"/hosts","path":"/servers"}])")
+                       .value());
+    auto patched = check(x);
+    assert(patched.find("d.out") != std::string::npos && patched.find("c.out") == std::string::npos);
+    assert(patched.find("\"servers\":[\"alpha") != std::string::npos);
+    assert(buffered_bytes(x) == patched.size());
+
+    // generate 不写缓存，多个线程可以同时生成同一棵只读的树
+    const Node shared = parser(text).value();
+    auto expected = generate(shared);
+    assert(!shared.link);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&]
+                             {
+                                 for (int j = 0; j < 100; j++)
+                                 {
+                                     assert(generate(shared) == expected);
+                                 } });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    std::cout << "test_cache ok" << std::endl;
+}
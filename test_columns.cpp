@@ -0,0 +1,68 @@
+// g++ -std=c++20 test_columns.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonSchema.cpp JsonColumns.cpp -o test_columns
+#include "Json.hpp"
+#include <cassert>
+using namespace json;
+
+static void check(const ColumnTable &table)
+{
+    assert(table.rows == 4);
+    assert(table.columns.size() == 4); // tags 是数组，mixed 类型冲突，都被丢弃
+    assert(!table.column("tags") && !table.column("mixed"));
+
+    auto id = table.column("id");
+    assert(id && id->type == 2 && id->size() == 4);
+    assert(id->ints[0] == 1 && id->ints[3] == 4);
+
+    // int 和 float 混合时按 float
+    auto score = table.column("score");
+    assert(score && score->type == 3);
+    assert(score->floats[0] == 1.5 && score->floats[1] == 2.0);
+    assert(!score->is_valid(2)); // null
+    assert(score->is_valid(3) && score->floats[3] == 4.25);
+
+    auto name = table.column("name");
+    assert(name && name->type == 4);
+    assert(name->string_at(0) == "a" && name->string_at(1) == "bb");
+    assert(!name->is_valid(2) && name->string_at(2).empty()); // 缺失
+    assert(!name->is_valid(3));                               // 类型不符
+
+    auto ok = table.column("ok");
+    assert(ok && ok->type == 1);
+    assert(ok->ints[0] == 1 && ok->ints[1] == 0);
+    assert(!ok->is_valid(3));
+
+    // 推断窗口之外才出现的字段不会变成列
+    assert(!table.column("late"));
+}
+
+int main()
+{
+    const char *text = R"([
+        {"id":1,"score":1.5,"name":"a","ok":true,"tags":[1],"mixed":1},
+        {"id":2,"score":2,"name":"bb","ok":false,"tags":[],"mixed":"x"},
+        {"id":3,"score":null,"ok":true},
+        {"id":4,"score":4.25,"name":5,"late":1}
+    ])";
+    check(extract_columns(parser(text).value(), 2));
+    check(extract_columns(std::string_view{text}, 2));
+
+    // 样本不超过数组长度，空数组得到空表
+    auto all = extract_columns(parser(text).value());
+    assert(all.rows == 4 && all.column("late"));
+    auto empty = extract_columns(std::string_view{"[]"});
+    assert(empty.rows == 0 && empty.columns.empty());
+
+    // 元素不是对象时抛异常
+    bool threw = false;
+    try
+    {
+        extract_columns(parser("[1,2]").value());
+    }
+    catch (std::runtime_error &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "test_columns ok" << std::endl;
+}
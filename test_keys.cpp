@@ -0,0 +1,65 @@
+// g++ -std=c++20 -DJSON_INTERN_KEYS test_keys.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonPatch.cpp JsonSchema.cpp JsonColumns.cpp -o test_keys
+// 也可以不定义 JSON_INTERN_KEYS 编译，验证两种模式输出一致
+#include "Json.hpp"
+#include <cassert>
+#include <thread>
+using namespace json;
+
+// 在 main 之前、也可能在 JsonKeyTable.cpp 的静态对象之前解析，驻留表必须已经可用
+static const Node defaults = parser(R"({"port":8080,"hosts":["a","b"]})").value();
+
+int main()
+{
+    const Node &port = defaults["port"];
+    assert(std::get<Int>(port.value) == 8080);
+#ifdef JSON_INTERN_KEYS
+    assert(KeyTable::find("port") && KeyTable::find("hosts"));
+    assert(KeyTable::find("port")->id == InternedKey{"port"}.id());
+#endif
+
+    // 输出顺序不能依赖之前驻留过哪些 key
+    parser(R"({"zeta":1})");
+    assert(generate(parser(R"({"alpha":1,"zeta":2})").value()) == R"({"alpha":1,"zeta":2})");
+
+    // 查找失败不能让驻留表增长
+    auto doc = parser(R"({"a":{"b":1},"list":[{"id":1}]})").value();
+    for (const char *patch : {R"([{"op":"remove","path":"/nope1"}])", R"([{"op":"replace","path":"/a/nope2","value":1}])",
+                              R"([{"op":"test","path":"/nope3/x","value":1}])"})
+    {
+        auto ops = parser(patch).value();
+        size_t parsed = KeyTable::size(); // patch 文本里的 key 本身会被驻留
+        try
+        {
+            apply_patch(doc, ops);
+            assert(false);
+        }
+        catch (std::runtime_error &)
+        {
+        }
+        assert(KeyTable::size() == parsed);
+    }
+    auto &items = std::get<Object>(doc.value);
+    assert(find_key(items, "missing") == items.end());
+    assert(find_key(items, "a") != items.end());
+    auto table = extract_columns(parser(R"([{"id":1},{"other":2}])").value(), 1);
+    assert(table.rows == 2 && !table.columns[0].is_valid(1));
+
+    // 多线程驻留同一批 key
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        threads.emplace_back([]
+                             {
+                                 for (int j = 0; j < 1000; j++)
+                                 {
+                                     InternedKey key{"key" + std::to_string(j % 100)};
+                                     assert(InternedKey::lookup(key.str())->id() == key.id());
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    assert(InternedKey{"key7"} == InternedKey{std::string{"key7"}});
+    std::cout << "test_keys ok" << std::endl;
+}
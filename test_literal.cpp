@@ -0,0 +1,32 @@
+// g++ -std=c++20 test_literal.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonSchema.cpp -o test_literal
+#include "JsonLiteral.hpp"
+#include <cassert>
+using namespace json;
+
+constexpr auto doc = R"({"port":8080,"hosts":["a","b"],"ratio":1.25e1,"on":true,"none":null,"nested":{"x":[1,[2,3],{}]}})"_json;
+static_assert(doc["port"].as_int() == 8080);
+static_assert(doc["hosts"].size() == 2 && doc["hosts"][1].as_string() == "b");
+static_assert(doc["ratio"].as_float() == 12.5);
+static_assert(doc["on"].as_bool() && doc["none"].is_null());
+static_assert(doc["nested"]["x"][1][1].as_int() == 3);
+static_assert(R"([1,2])"_json[0].as_int() == 1); // 下标 0 不能和 key 查找产生歧义
+static_assert("0.1"_json.as_float() == 0.1);     // 快速路径与 std::stod 一致
+static_assert("0.0000000000000000001"_json.as_float() == 1e-19); // 前导 0 不占有效数字
+static_assert("1234567890123456789"_json.type() == 2 && "1234567890123456789"_json.as_int() == 1234567890123456789);
+static_assert("9223372036854775807"_json.as_int() == INT64_MAX);
+static_assert("-9223372036854775808"_json.as_int() == INT64_MIN);
+static_assert("9223372036854775808"_json.type() == 3); // 超出 int64 才按浮点数处理
+
+int main()
+{
+    auto node = doc.to_node();
+    assert(generate(node) == generate(parser(R"({"port":8080,"hosts":["a","b"],"ratio":12.5,"on":true,"none":null,"nested":{"x":[1,[2,3],{}]}})").value()));
+    // 超出快速路径的数字，to_node() 与 parser() 的结果必须完全一致
+    assert("1e300"_json.to_node() == parser("1e300").value());
+    assert(std::get<Float>("1e-300"_json.to_node().value) == 1e-300);
+    assert("123456789.123456789e5"_json.to_node() == parser("123456789.123456789e5").value());
+    assert("0.0000000000000000001"_json.to_node() == parser("0.0000000000000000001").value());
+    assert("1234567890123456789"_json.to_node() == parser("1234567890123456789").value());
+    assert(std::get<Int>("1234567890123456789"_json.to_node().value) == 1234567890123456789);
+    std::cout << "test_literal ok" << std::endl;
+}
@@ -0,0 +1,74 @@
+// g++ -std=c++20 test_patch.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonSchema.cpp JsonPatch.cpp -o test_patch
+#include "Json.hpp"
+#include <cassert>
+using namespace json;
+
+static bool throws(Node &doc, const char *patch)
+{
+    try
+    {
+        apply_patch(doc, parser(patch).value());
+    }
+    catch (std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    auto from = parser(R"({"a":1,"b":[1,2,3,4],"c":{"d":"x","e/f":true},"g":null})").value();
+
+    // diff 之后再 apply，结果应该和目标完全一样
+    auto to = from;
+    to["a"] = Node{Int{2}};
+    auto &b = std::get<Array>(to["b"].value);
+    b.insert(b.begin() + 2, Node{Int{9}});
+    std::get<Object>(to["c"].value).erase("e/f");
+    to["h"] = Node{String{"new"}};
+    auto patch = diff(from, to);
+    auto doc = from;
+    apply_patch(doc, patch);
+    assert(doc == to);
+    assert(std::get<Array>(diff(from, from).value).empty());
+    // 类型变化时整个替换，1 和 1.0 也算变化
+    auto retyped = from;
+    retyped["a"] = Node{Float{1}};
+    retyped["c"] = Node{Array{}};
+    auto ops = diff(from, retyped);
+    assert(std::get<Array>(ops.value).size() == 2);
+    doc = from;
+    apply_patch(doc, ops);
+    assert(doc == retyped);
+
+    // 各种操作
+    doc = from;
+    apply_patch(doc, parser(R"([{"op":"move","from":"/c/d","path":"/b/-"},{"op":"copy","from":"/a","path":"/z"},
+                               {"op":"test","path":"/z","value":1.0},{"op":"remove","path":"/b/0"}])")
+                         .value());
+    assert(generate(doc) == R"({"a":1,"b":[2,3,4,"x"],"c":{"e/f":true},"g":null,"z":1})");
+
+    // 中途失败时整个 patch 不生效
+    doc = from;
+    assert(throws(doc, R"([{"op":"add","path":"/new","value":1},{"op":"replace","path":"/a","value":5},
+                          {"op":"remove","path":"/b/1"},{"op":"add","path":"/b/0","value":7},
+                          {"op":"move","from":"/c/d","path":"/moved"},{"op":"test","path":"/a","value":6}])"));
+    assert(doc == from);
+    assert(throws(doc, R"([{"op":"remove","path":"/g"},{"op":"remove","path":"/b/99"}])"));
+    assert(doc == from);
+    // move 的目标路径不存在时，被移走的值要原样放回
+    assert(throws(doc, R"([{"op":"move","from":"/c","path":"/missing/c"}])"));
+    assert(doc == from);
+    // move 成功之后被后面的操作回滚：先从目标位置拿回来，再放回原位
+    assert(throws(doc, R"([{"op":"move","from":"/b/0","path":"/c/b0"},{"op":"move","from":"/c","path":"/b/1"},
+                          {"op":"move","from":"/a","path":""},{"op":"test","path":"","value":0}])"));
+    assert(doc == from);
+
+    // merge patch：null 表示删除，非对象整个替换
+    doc = from;
+    apply_merge_patch(doc, parser(R"({"a":null,"c":{"d":"y","e/f":null},"b":{"k":1},"q":[1]})").value());
+    assert(generate(doc) == R"({"b":{"k":1},"c":{"d":"y"},"g":null,"q":[1]})");
+
+    std::cout << "test_patch ok" << std::endl;
+}
@@ -0,0 +1,87 @@
+// g++ -std=c++20 test_schema.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonSchema.cpp -o test_schema
+#include "Json.hpp"
+#include <cassert>
+using namespace json;
+
+static Schema schema(const char *text)
+{
+    return compile_schema(parser(text).value());
+}
+
+static bool valid(const Schema &s, const char *text)
+{
+    return parser(text, s).has_value();
+}
+
+static bool rejected_by_compile(const char *text)
+{
+    try
+    {
+        schema(text);
+    }
+    catch (std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    // 基本的类型、必填字段、枚举、范围和长度
+    auto user = schema(R"({"type":"object","required":["id","name"],"properties":{)"
+                       R"("id":{"type":"integer","minimum":1},)"
+                       R"("name":{"type":"string","maxLength":5},)"
+                       R"("role":{"enum":["admin","guest"]},)"
+                       R"("tags":{"type":"array","items":{"type":"string"}}}})");
+    assert(valid(user, R"({"id":1,"name":"bob","role":"admin","tags":["a","b"]})"));
+    assert(!valid(user, R"({"id":1})"));                              // 缺少 name
+    assert(!valid(user, R"({"id":0,"name":"bob"})"));                 // 小于 minimum
+    assert(!valid(user, R"({"id":1,"name":"robert"})"));              // 超过 maxLength
+    assert(!valid(user, R"({"id":1,"name":"bob","role":"root"})"));   // 不在 enum 里
+    assert(!valid(user, R"({"id":1,"name":"bob","tags":["a",2]})"));  // 数组元素类型不对
+    assert(!valid(user, R"(["id",1])"));                              // 根节点类型不对
+    assert(!valid(user, R"({"id":"1","name":"bob"})"));
+
+    // 布尔 schema：true 接受一切，false 拒绝一切
+    assert(valid(schema("true"), R"({"any":[1,"x",null]})"));
+    auto nothing = schema("false");
+    assert(!valid(nothing, "null"));
+    assert(!valid(nothing, "1"));
+    assert(!valid(nothing, "{}"));
+    auto forbidden = schema(R"({"properties":{"legacy":false}})");
+    assert(valid(forbidden, R"({"name":"x"})"));
+    assert(!valid(forbidden, R"({"name":"x","legacy":1})"));
+
+    // integer 接受没有小数部分的 Float，同时写了 number 时接受任意数字
+    auto integer = schema(R"({"type":"integer"})");
+    assert(valid(integer, "1"));
+    assert(valid(integer, "1.0"));
+    assert(std::get<Float>(parser("1.0", integer)->value) == 1.0);
+    assert(!valid(integer, "1.5"));
+    assert(!valid(integer, R"("1")"));
+    assert(valid(schema(R"({"type":["integer","number"]})"), "1.5"));
+    assert(valid(schema(R"({"type":"number"})"), "1.5"));
+
+    // enum 按数值比较数字，和 integer 的处理一致
+    auto options = schema(R"({"enum":[1,"a",[1,{"k":2}]]})");
+    assert(valid(options, "1") && valid(options, "1.0") && valid(options, R"("a")"));
+    assert(valid(options, R"([1.0,{"k":2.0}])"));
+    assert(!valid(options, "2") && !valid(options, R"("b")") && !valid(options, R"([1,{"k":3}])"));
+
+    // x-ignore 只能用在 properties 下的字段上
+    auto ignore = schema(R"({"properties":{"blob":{"x-ignore":true},"id":{"type":"integer"}}})");
+    auto doc = parser(R"({"blob":{"huge":[1,2,3]},"id":7})", ignore).value();
+    assert(std::get<Object>(doc.value).size() == 1);
+    assert(std::get<Int>(doc["id"].value) == 7);
+    assert(rejected_by_compile(R"({"items":{"x-ignore":true}})"));
+    assert(rejected_by_compile(R"({"x-ignore":true})"));
+    assert(rejected_by_compile(R"({"properties":{"a":{"x-ignore":1}}})"));
+
+    // 不认识的关键字和格式错误的 schema 在 compile 时报错
+    assert(rejected_by_compile(R"({"pattern":"^a"})"));
+    assert(rejected_by_compile(R"({"type":"integr"})"));
+    assert(rejected_by_compile("1"));
+
+    std::cout << "test_schema ok" << std::endl;
+}
@@ -0,0 +1,25 @@
+// g++ -std=c++20 -DJSON_ENABLE_STATS test_stats.cpp struct_JsonParser.cpp JsonGenerator.cpp JsonKeyTable.cpp JsonStats.cpp JsonSchema.cpp -o test_stats
+#include "Json.hpp"
+#include <cassert>
+using namespace json;
+
+int main()
+{
+    reset_stats();
+    auto node = parser(R"({"a":12345,"b":[1.5,"x\\y\"z",[[true]]],"big":1234567890123456789})");
+    assert(node);
+    assert(std::get<String>(std::get<Array>((*node)["b"].value)[1].value) == R"(x\\y\"z)"); // \" 不会提前结束字符串
+    assert(std::get<Int>((*node)["big"].value) == 1234567890123456789LL);                 // 19 位整数走 std::stoll
+    generate(*node);
+#ifdef JSON_ENABLE_STATS
+    const auto &s = stats();
+    assert(s.escapes == 2); // \\ 和 \" 各算一次
+    assert(s.strings == 4); // 三个 key 加一个字符串值
+    assert(s.max_depth == 4);
+    assert(s.number_fast_path == 1 && s.number_fallback == 2);
+    assert(s.nodes[6] == 1 && s.nodes[5] == 3 && s.nodes[2] == 2);
+    assert(s.phase_ns[Stats::Parse] > 0 && s.phase_ns[Stats::Serialize] > 0);
+    std::cout << stats().to_node() << std::endl;
+#endif
+    std::cout << "test_stats ok" << std::endl;
+}